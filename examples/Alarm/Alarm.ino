@@ -13,7 +13,8 @@ void setup()
   while (!Serial);
 
   // Set thermometer sensor alarm triggers (20..25 C) and resolution
-  // (10 bits). Iterate all sensors and write configuration.
+  // (10 bits). Iterate all sensors and update configuration. Only
+  // sensors with a different configuration are written
   uint8_t* rom = sensor.rom();
   int8_t last = owi.FIRST;
   do {
@@ -21,7 +22,7 @@ void setup()
     if (last == owi.ERROR) break;
     sensor.resolution(10);
     sensor.set_trigger(20, 25);
-    ASSERT(sensor.write_scratchpad(false));
+    ASSERT(sensor.configure());
   } while (last != owi.LAST);
 }
 
@@ -0,0 +1,77 @@
+#include "GPIO.h"
+#include "TWI.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Hardware/OWI.h"
+#include "Driver/DS18B20.h"
+
+// Bus time budget for a polling plan; broadcast convert request,
+// conversion, and read scratchpad of each sensor. The plan is
+// checked at compile time against the period for both the software
+// and the DS2482 bus manager.
+
+typedef Software::OWI<BOARD::D7> Bus;
+typedef Hardware::OWI Bridge;
+
+const uint8_t SENSORS = 16;
+const uint32_t PERIOD = 1000000UL;
+const uint32_t BRIDGE_PERIOD = 2000000UL;
+
+template<typename BUS>
+constexpr uint32_t plan()
+{
+  return (DS18B20::Cost<BUS>::convert_request(true)
+	  + DS18B20::Cost<BUS>::conversion()
+	  + SENSORS * DS18B20::Cost<BUS>::read_scratchpad());
+}
+
+static_assert(plan<Bus>() < PERIOD, "software bus polling plan exceeds period");
+static_assert(plan<Bridge>() < BRIDGE_PERIOD, "bridge polling plan exceeds period");
+
+Bus owi;
+DS18B20 sensor(owi);
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+
+  // Print line time (us) of bus and device operations
+  Serial.print(F("reset="));
+  Serial.println(OWI::Cost<Bus>::reset());
+  Serial.print(F("match_rom="));
+  Serial.println(OWI::Cost<Bus>::match_rom());
+  Serial.print(F("search="));
+  Serial.println(OWI::Cost<Bus>::search());
+  Serial.print(F("read_scratchpad="));
+  Serial.println(DS18B20::Cost<Bus>::read_scratchpad());
+  Serial.print(F("plan="));
+  Serial.println(plan<Bus>());
+  Serial.print(F("plan(bridge)="));
+  Serial.println(plan<Bridge>());
+}
+
+void loop()
+{
+  // Measure search and read of all sensors; compare with the model
+  sensor.convert_request(true);
+  sensor.convert_await();
+  uint32_t start = micros();
+  int8_t last = owi.FIRST;
+  uint8_t count = 0;
+  do {
+    last = owi.search_rom(sensor.FAMILY_CODE, sensor.rom(), last);
+    if (last == owi.ERROR) break;
+    sensor.read_scratchpad(false);
+    count += 1;
+  } while (last != owi.LAST);
+  uint32_t us = micros() - start;
+  Serial.print(F("sensors="));
+  Serial.print(count);
+  Serial.print(F(",us="));
+  Serial.print(us);
+  Serial.print(F(",model="));
+  Serial.println(count * (OWI::Cost<Bus>::search()
+			  + DS18B20::Cost<Bus>::read_scratchpad(false)));
+  delay(1000);
+}
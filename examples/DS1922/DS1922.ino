@@ -0,0 +1,49 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Driver/DS1922.h"
+
+Software::OWI<BOARD::D7> owi;
+DS1922 logger(owi);
+
+// Print log pages as they are downloaded; address and data in hex
+bool print(void* env, uint16_t addr, const uint8_t* buf, uint8_t count)
+{
+  (void) env;
+  Serial.print(addr, HEX);
+  Serial.print(':');
+  for (uint8_t i = 0; i < count; i++) {
+    if (buf[i] < 0x10) Serial.print(0);
+    Serial.print(buf[i], HEX);
+  }
+  Serial.println();
+  return (true);
+}
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+}
+
+void loop()
+{
+  // Download mission log from all loggers on the bus
+  int8_t last = owi.FIRST;
+  do {
+    last = owi.search_rom(logger.FAMILY_CODE, logger.rom(), last);
+    if (last == owi.ERROR) break;
+    if (!logger.read_status()) continue;
+    Serial.print(F("mission="));
+    Serial.print(logger.mission_in_progress());
+    Serial.print(F(",samples="));
+    Serial.println(logger.mission_samples());
+    uint32_t start = millis();
+    int32_t count = logger.read_log(print, NULL, logger.log_size());
+    Serial.print(F("bytes="));
+    Serial.print(count);
+    Serial.print(F(",ms="));
+    Serial.println(millis() - start);
+  } while (last != owi.LAST);
+  delay(10000);
+}
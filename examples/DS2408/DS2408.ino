@@ -0,0 +1,54 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Driver/DS2408.h"
+
+Software::OWI<BOARD::D7> owi;
+DS2408 pio(owi);
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+
+  // Set up conditional search on activity on any input (P4..P7)
+  // for all switches on the bus
+  int8_t last = owi.FIRST;
+  do {
+    last = owi.search_rom(pio.FAMILY_CODE, pio.rom(), last);
+    if (last == owi.ERROR) break;
+    pio.conditional_search(0xf0, 0x00, true, false, false);
+    pio.reset_activity_latches();
+  } while (last != owi.LAST);
+}
+
+void loop()
+{
+  // Find switches with input activity; toggle outputs (P0..P3),
+  // and sample inputs with channel access read streaming
+  static uint8_t output = 0;
+  int8_t last = owi.FIRST;
+  do {
+    last = owi.alarm_search(pio.rom(), last);
+    if (last == owi.ERROR) break;
+    if (!pio.read_registers()) continue;
+    Serial.print(F("activity="));
+    Serial.print(pio.activity_latch(), BIN);
+    uint8_t state;
+    if (pio.channel_write(~output | 0xf0, &state)) {
+      Serial.print(F(",state="));
+      Serial.print(state, BIN);
+    }
+    uint8_t sample[pio.BLOCK_MAX];
+    if (pio.channel_read_begin() && pio.channel_read(sample, sizeof(sample))) {
+      Serial.print(F(",sample="));
+      Serial.print(sample[0], BIN);
+      Serial.print(F(".."));
+      Serial.print(sample[sizeof(sample) - 1], BIN);
+    }
+    Serial.println();
+    pio.reset_activity_latches();
+  } while (last != owi.LAST);
+  output += 1;
+  delay(1000);
+}
@@ -0,0 +1,55 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Coupler/OWI.h"
+#include "Driver/DS18B20.h"
+
+Software::OWI<BOARD::D7> trunk;
+Coupler::OWI::node_t node[16];
+Coupler::OWI owi(trunk, node, sizeof(node) / sizeof(node[0]));
+DS18B20 sensor(owi);
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+
+  // Discover couplers and devices on trunk and branches
+  int8_t count = owi.discover();
+  Serial.print(F("count="));
+  Serial.println(count);
+  for (int8_t ix = 0; ix < count; ix++) {
+    Serial.print(ix);
+    Serial.print(F(":branch="));
+    Serial.print(owi.branch(ix), HEX);
+    Serial.print(F(",rom="));
+    uint8_t* rom = owi.rom(ix);
+    for (uint8_t i = 0; i < owi.ROM_MAX; i++) {
+      if (rom[i] < 0x10) Serial.print(0);
+      Serial.print(rom[i], HEX);
+    }
+    Serial.println();
+  }
+}
+
+void loop()
+{
+  // Request conversion and read thermometers in node table (branch)
+  // order; branches are switched by match rom
+  const uint8_t FAMILY = sensor.FAMILY_CODE;
+  for (int16_t ix = owi.next(FAMILY); ix >= 0; ix = owi.next(FAMILY, ix)) {
+    sensor.rom(owi.rom(ix));
+    sensor.convert_request();
+  }
+  delay(750);
+  for (int16_t ix = owi.next(FAMILY); ix >= 0; ix = owi.next(FAMILY, ix)) {
+    sensor.rom(owi.rom(ix));
+    if (!sensor.read_scratchpad()) continue;
+    Serial.print(ix);
+    Serial.print(F(":temperature="));
+    Serial.println(sensor.temperature());
+  }
+  Serial.print(F("switches="));
+  Serial.println(owi.switches());
+  delay(2000);
+}
@@ -0,0 +1,49 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Driver/DS2431.h"
+
+Software::OWI<BOARD::D7> owi;
+DS2431 eeprom(owi);
+
+// Page cache for the whole device memory
+uint8_t cache[DS2431::MEMORY_MAX / DS2431::PAGE_MAX][DS2431::PAGE_MAX];
+
+// Calibration data stored in device memory
+struct calibration_t {
+  uint16_t count;
+  int16_t offset;
+  int16_t gain;
+};
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+
+  // Find device and load the memory into the cache
+  uint8_t* rom = eeprom.rom();
+  if (owi.search_rom(eeprom.FAMILY_CODE, rom) == owi.ERROR) {
+    Serial.println(F("no device"));
+    while (1);
+  }
+  eeprom.cache(cache, sizeof(cache) / sizeof(cache[0]));
+  if (!eeprom.load()) Serial.println(F("load failed"));
+}
+
+void loop()
+{
+  // Read calibration from cache; update count and write back
+  calibration_t calibration;
+  if (eeprom.read(&calibration, 0, sizeof(calibration)) < 0) return;
+  Serial.print(F("count="));
+  Serial.print(calibration.count);
+  Serial.print(F(",offset="));
+  Serial.print(calibration.offset);
+  Serial.print(F(",gain="));
+  Serial.println(calibration.gain);
+  calibration.count += 1;
+  if (eeprom.write(0, &calibration, sizeof(calibration)) < 0)
+    Serial.println(F("write failed"));
+  delay(5000);
+}
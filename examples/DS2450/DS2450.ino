@@ -0,0 +1,48 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Driver/DS2450.h"
+
+Software::OWI<BOARD::D7> owi;
+DS2450 adc(owi);
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+}
+
+void loop()
+{
+  // Broadcast a convert request for all channels to all converters
+  // Print rom code and channel values in milli-volt
+
+  adc.resolution(12);
+  if (!adc.convert_request(0x0f, true)) return;
+  delay(adc.conversion_time());
+
+  int8_t last = owi.FIRST;
+  uint8_t* rom = adc.rom();
+  do {
+    // Search for the next converter; configure and read all channels
+    last = owi.search_rom(adc.FAMILY_CODE, rom, last);
+    if (last == owi.ERROR) break;
+    adc.invalidate();
+    if (!adc.configure(false)) continue;
+    if (!adc.read_conversion()) continue;
+
+    // Print rom code and channel values
+    for (size_t i = 0; i < owi.ROM_MAX; i++) {
+      if (rom[i] < 0x10) Serial.print(0);
+      Serial.print(rom[i], HEX);
+    }
+    for (uint8_t chan = 0; chan < adc.CHANNEL_MAX; chan++) {
+      Serial.print(chan == 0 ? ':' : ',');
+      Serial.print(adc.millivolt(chan));
+    }
+    Serial.println(F(" mV"));
+  } while (last != owi.LAST);
+
+  Serial.println();
+  delay(5000);
+}
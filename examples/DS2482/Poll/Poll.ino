@@ -0,0 +1,49 @@
+#include "GPIO.h"
+#include "TWI.h"
+#include "Hardware/TWI.h"
+#include "OWI.h"
+#include "Hardware/OWI.h"
+
+Hardware::TWI twi;
+Hardware::OWI owi(twi);
+
+// Queued requests; read rom of single device
+Hardware::OWI::request_t req[owi.ROM_MAX + 2];
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+}
+
+void loop()
+{
+  // Queue reset, read rom command and rom code
+  owi.submit(req[0], owi.OP_RESET);
+  owi.submit(req[1], owi.OP_WRITE_BYTE, owi.READ_ROM);
+  for (size_t i = 2; i < owi.ROM_MAX + 2; i++)
+    owi.submit(req[i], owi.OP_READ_BYTE);
+
+  // Poll requests; the TWI bus is free between polls
+  uint32_t polls = 0;
+  while (owi.poll()) polls += 1;
+
+  // Check presence and print rom code
+  Serial.print(F("polls="));
+  Serial.print(polls);
+  if ((req[0].value & owi.STATUS_PPD) == 0) {
+    Serial.println(F(",no presence"));
+  }
+  else {
+    uint8_t rom[owi.ROM_MAX];
+    for (size_t i = 0; i < owi.ROM_MAX; i++) rom[i] = req[i + 2].value;
+    Serial.print(F(",rom="));
+    for (size_t i = 0; i < owi.ROM_MAX; i++) {
+      if (rom[i] < 0x10) Serial.print(0);
+      Serial.print(rom[i], HEX);
+    }
+    Serial.print(F(",crc="));
+    Serial.println(owi.crc(rom, owi.ROM_MAX) == 0 ? F("ok") : F("error"));
+  }
+  delay(2000);
+}
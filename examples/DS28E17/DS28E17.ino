@@ -0,0 +1,53 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "TWI.h"
+#include "Software/OWI.h"
+#include "Driver/DS28E17.h"
+
+Software::OWI<BOARD::D7> owi;
+DS28E17 bridge(owi);
+DS28E17::TWI twi(bridge);
+
+// Example I2C device; BMP280 chip identity register
+const uint8_t ADDR = 0x76;
+const uint8_t ID = 0xd0;
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+
+  // Find the bridge and set I2C clock speed
+  if (owi.search_rom(bridge.FAMILY_CODE, bridge.rom()) == owi.ERROR) {
+    Serial.println(F("DS28E17: not found"));
+    while (1);
+  }
+  bridge.write_configuration(bridge.SPEED_400KHZ);
+}
+
+void loop()
+{
+  // Register read with a single write-read bridge operation
+  uint8_t id;
+  uint8_t reg = ID;
+  if (bridge.write_read(ADDR, &reg, sizeof(reg), &id, sizeof(id))) {
+    Serial.print(F("id="));
+    Serial.println(id, HEX);
+  }
+  else {
+    Serial.print(F("status="));
+    Serial.println(bridge.status(), BIN);
+  }
+
+  // Register read through the TWI bus adapter; write and read
+  TWI::Device dev(twi, ADDR);
+  dev.acquire();
+  bool res = (dev.write(&reg, sizeof(reg)) == sizeof(reg))
+    && (dev.read(&id, sizeof(id)) == sizeof(id));
+  dev.release();
+  if (res) {
+    Serial.print(F("twi:id="));
+    Serial.println(id, HEX);
+  }
+  delay(1000);
+}
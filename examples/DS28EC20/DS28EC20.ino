@@ -0,0 +1,77 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Driver/DS28EC20.h"
+
+Software::OWI<BOARD::D7> owi;
+DS28EC20 eeprom(owi);
+
+// Event log in device memory; record ring after the header page
+struct header_t {
+  uint16_t events;
+  uint16_t next;
+};
+
+struct event_t {
+  uint32_t timestamp;
+  uint16_t value;
+  uint8_t reserved[10];
+};
+
+const uint16_t LOG_START = DS28EC20::PAGE_MAX;
+const uint16_t LOG_MAX = (DS28EC20::MEMORY_MAX - LOG_START) / sizeof(event_t);
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+
+  // Find device
+  uint8_t* rom = eeprom.rom();
+  if (owi.search_rom(eeprom.FAMILY_CODE, rom) == owi.ERROR) {
+    Serial.println(F("no device"));
+    while (1);
+  }
+}
+
+void loop()
+{
+  // Read header; append event and update header. The writes are
+  // merged with the memory contents and written in 32 byte rows
+  header_t header;
+  if (eeprom.read(&header, 0, sizeof(header)) < 0) return;
+  if (header.next >= LOG_MAX) {
+    header.events = 0;
+    header.next = 0;
+  }
+  event_t event;
+  memset(&event, 0, sizeof(event));
+  event.timestamp = millis();
+  event.value = analogRead(A0);
+  uint16_t addr = LOG_START + header.next * sizeof(event);
+  if (eeprom.write(addr, &event, sizeof(event)) < 0) {
+    Serial.println(F("write failed"));
+    return;
+  }
+  header.events += 1;
+  header.next += 1;
+  if (eeprom.write(0, &header, sizeof(header)) < 0) {
+    Serial.println(F("write failed"));
+    return;
+  }
+
+  // Read back and verify
+  event_t check;
+  if (eeprom.read(&check, addr, sizeof(check)) < 0
+      || memcmp(&check, &event, sizeof(event))) {
+    Serial.println(F("verify failed"));
+    return;
+  }
+  Serial.print(F("events="));
+  Serial.print(header.events);
+  Serial.print(F(",addr="));
+  Serial.print(addr);
+  Serial.print(F(",value="));
+  Serial.println(event.value);
+  delay(5000);
+}
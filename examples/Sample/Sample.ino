@@ -0,0 +1,60 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Driver/DS18B20.h"
+#include "Sample/Encoder.h"
+
+// Binary sample stream of thermometer readings; rom code dictionary
+// and samples with device index, delta time stamp and raw value.
+// Decode on the host with Sample/Decoder.h
+
+Software::OWI<BOARD::D7> owi;
+DS18B20 sensor(owi);
+Sample::Encoder encoder(Serial);
+
+// Resend the dictionary every DICTIONARY_PERIOD samples
+const uint16_t DICTIONARY_PERIOD = 1000;
+
+// Rom codes by index; the dictionary frame for an index is sent when
+// the rom code changes, i.e. a sensor was added or removed
+const uint8_t SENSOR_MAX = 16;
+uint8_t roms[SENSOR_MAX][OWI::ROM_MAX];
+uint8_t sensors = 0;
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+}
+
+void loop()
+{
+  static uint16_t samples = 0;
+  bool dictionary = (samples == 0);
+
+  // Broadcast a convert request to all thermometer sensors
+  if (!sensor.convert_request(true)) return;
+  sensor.convert_await();
+
+  // Read thermometers in search order; index is the search position
+  int8_t last = owi.FIRST;
+  uint8_t* rom = sensor.rom();
+  uint8_t index = 0;
+  do {
+    last = owi.search_rom(sensor.FAMILY_CODE, rom, last);
+    if (last == owi.ERROR || index == SENSOR_MAX) break;
+    if (dictionary
+	|| index >= sensors
+	|| memcmp(roms[index], rom, OWI::ROM_MAX)) {
+      memcpy(roms[index], rom, OWI::ROM_MAX);
+      encoder.rom(index, rom);
+    }
+    if (sensor.read_scratchpad(false)) {
+      encoder.sample(index, sensor.temperature_raw(), millis());
+      samples += 1;
+    }
+    index += 1;
+  } while (last != owi.LAST);
+  sensors = index;
+  if (samples >= DICTIONARY_PERIOD) samples = 0;
+}
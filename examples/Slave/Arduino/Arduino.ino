@@ -25,7 +25,7 @@ void loop()
   if (!owi.rom_command()) return;
 
   const size_t BUF_MAX = 32;
-  uint8_t buf[BUF_MAX];
+  uint8_t buf[BUF_MAX + 1];
   uint16_t value;
   uint8_t pin;
   uint8_t mode;
@@ -87,7 +87,7 @@ void loop()
       while (count--) owi.read();
       owi.read();
     }
-    else if (owi.read(buf, count)) {
+    else if (owi.read(buf, count + 1)) {
       eeprom_write_block(buf, bp, count);
       res = 0b10;
     }
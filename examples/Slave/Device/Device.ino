@@ -0,0 +1,106 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Slave/OWI.h"
+#include "Slave/Device.h"
+
+/** DS18B20 family code. */
+static const uint8_t FAMILY_CODE = 0x28;
+
+/**
+ * DS18B20 Function Commands.
+ */
+enum {
+  CONVERT_T = 0x44,		//!< Initiate temperature conversion.
+  READ_SCRATCHPAD = 0xBE,	//!< Read scratchpad including crc byte.
+  WRITE_SCRATCHPAD = 0x4E	//!< Write data to scratchpad.
+} __attribute__((packed));
+
+/**
+ * DS18B20 Scratchpad structure.
+ */
+struct scratchpad_t {
+  int16_t temperature;		//!< Temperature reading (9-12 bits).
+  int8_t high_trigger;		//!< High temperature trigger.
+  int8_t low_trigger;		//!< Low temperature trigger.
+  uint8_t configuration;	//!< Configuration; resolution, alarm.
+  uint8_t reserved[3];		//!< Reserved.
+} __attribute__((packed));
+
+// Slave device one wire access; use random rom code
+typedef Slave::Device<BOARD::D7> Device;
+Slave::OWI<BOARD::D7> owi(FAMILY_CODE);
+
+// Scratchpad and prepared response with check sum
+scratchpad_t scratchpad = {
+  0x0550,			//!< 85 C default temperature,
+  75,				//!< 75 C high trigger, and
+  70,				//!< 70 C low trigger
+  0x3f,				//!< 10 bits conversion
+  { 0, 0, 0 }			//!< Reserved
+};
+Device::Response<sizeof(scratchpad)> response;
+
+// Analog pin used for emulated temperature reading
+const int pin = A0;
+
+// DS18B20 emulation; conversion prepares the scratchpad response
+void convert(Device& dev, uint8_t cmd)
+{
+  (void) cmd;
+  int16_t value = analogRead(pin) - 512;
+  scratchpad.temperature = (value << 2);
+  value >>= 2;
+  dev.owi().alarm(value >= scratchpad.high_trigger ||
+		  value <= scratchpad.low_trigger);
+  response.set(&scratchpad, sizeof(scratchpad));
+}
+
+void read_scratchpad(Device& dev, uint8_t cmd)
+{
+  (void) cmd;
+  dev.send(response);
+}
+
+void write_scratchpad(Device& dev, uint8_t cmd)
+{
+  (void) cmd;
+  dev.owi().read(&scratchpad.high_trigger, 3);
+  response.set(&scratchpad, sizeof(scratchpad));
+}
+
+// Function command table
+const Device::command_t command[] = {
+  { CONVERT_T, convert },
+  { READ_SCRATCHPAD, read_scratchpad },
+  { WRITE_SCRATCHPAD, write_scratchpad }
+};
+
+// Memory regions; scratchpad, configuration in EEPROM (data memory
+// on other architectures than AVR), and name
+#if defined(ARDUINO_ARCH_AVR)
+uint8_t config[16] EEMEM;
+const uint8_t CONFIG_MEMORY = Device::MEMORY_EEPROM;
+#else
+uint8_t config[16];
+const uint8_t CONFIG_MEMORY = Device::MEMORY_SRAM;
+#endif
+const char name[] PROGMEM = "DS18B20 emulation";
+const Device::region_t region[] = {
+  { Device::MEMORY_SRAM, false, sizeof(scratchpad), &scratchpad },
+  { CONFIG_MEMORY, true, sizeof(config), config },
+  { Device::MEMORY_PROGMEM, false, sizeof(name), (void*) name }
+};
+
+Device device(owi,
+	      command, sizeof(command) / sizeof(command[0]),
+	      region, sizeof(region) / sizeof(region[0]));
+
+void setup()
+{
+  response.set(&scratchpad, sizeof(scratchpad));
+}
+
+void loop()
+{
+  device.service();
+}
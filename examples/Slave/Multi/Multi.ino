@@ -0,0 +1,79 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Slave/Multi.h"
+
+/** DS18B20 family code. */
+static const uint8_t FAMILY_CODE = 0x28;
+
+/**
+ * DS18B20 Function Commands.
+ */
+enum {
+  CONVERT_T = 0x44,		//!< Initiate temperature conversion.
+  READ_SCRATCHPAD = 0xBE,	//!< Read scratchpad including crc byte.
+  WRITE_SCRATCHPAD = 0x4E	//!< Write data to scratchpad.
+} __attribute__((packed));
+
+/**
+ * DS18B20 Scratchpad structure.
+ */
+struct scratchpad_t {
+  int16_t temperature;		//!< Temperature reading (9-12 bits).
+  int8_t high_trigger;		//!< High temperature trigger.
+  int8_t low_trigger;		//!< Low temperature trigger.
+  uint8_t configuration;	//!< Configuration; resolution, alarm.
+  uint8_t reserved[3];		//!< Reserved.
+} __attribute__((packed));
+
+// Emulate four thermometers on one pin; analog pins A0..A3
+typedef Slave::Multi<BOARD::D7> Rack;
+const uint8_t SENSORS = 4;
+scratchpad_t scratchpad[SENSORS];
+
+// DS18B20 emulation; convert and write scratchpad are broadcast or
+// addressed, the parameters are read once and given to all sensors
+void thermometer(Rack& owi, Rack::identity_t& id, uint8_t cmd)
+{
+  uint8_t ix = owi.index(id);
+  scratchpad_t& sp = scratchpad[ix];
+  int16_t value;
+  switch (cmd) {
+  case CONVERT_T:
+    value = analogRead(A0 + ix) - 512;
+    sp.temperature = (value << 2);
+    value >>= 2;
+    owi.alarm(ix, value >= sp.high_trigger || value <= sp.low_trigger);
+    break;
+  case READ_SCRATCHPAD:
+    if (owi.broadcast()) break;
+    owi.write(&sp, sizeof(sp));
+    break;
+  case WRITE_SCRATCHPAD:
+    owi.param(&sp.high_trigger, 3);
+    break;
+  }
+}
+
+// Identity table; rom code (check sum generated), label and handler
+Rack::identity_t identity[SENSORS] = {
+  { { FAMILY_CODE, 0x01, 0, 0, 0, 0, 0 }, 0, thermometer },
+  { { FAMILY_CODE, 0x02, 0, 0, 0, 0, 0 }, 1, thermometer },
+  { { FAMILY_CODE, 0x03, 0, 0, 0, 0, 0 }, 2, thermometer },
+  { { FAMILY_CODE, 0x04, 0, 0, 0, 0, 0 }, 3, thermometer }
+};
+Rack owi(identity, SENSORS);
+
+void setup()
+{
+  for (uint8_t ix = 0; ix < SENSORS; ix++) {
+    scratchpad[ix].temperature = 0x0550;
+    scratchpad[ix].high_trigger = 75;
+    scratchpad[ix].low_trigger = 70;
+    scratchpad[ix].configuration = 0x3f;
+  }
+}
+
+void loop()
+{
+  owi.dispatch();
+}
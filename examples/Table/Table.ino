@@ -0,0 +1,45 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Driver/DS18B20.h"
+
+Software::OWI<BOARD::D7> owi;
+
+// Single thermometer driver instance; bound to table entries
+DS18B20 sensor(owi);
+
+// Table with thermometer rom codes (8 bytes per entry)
+const uint8_t ROM[] PROGMEM = {
+  0x28, 0x9a, 0x80, 0x40, 0x04, 0x00, 0x00, 0xd5,
+  0x28, 0x05, 0x56, 0x40, 0x04, 0x00, 0x00, 0x82,
+  0x28, 0x4e, 0x9c, 0x1d, 0x05, 0x00, 0x00, 0x7e
+};
+OWI::Table table(ROM, sizeof(ROM) / OWI::ROM_MAX, OWI::Table::PROGRAM_MEMORY);
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+}
+
+void loop()
+{
+  // Broadcast a convert request to all thermometer sensors
+  // Bind the driver to each table entry (handle) and print
+  // handle and temperature in centi-degrees
+
+  if (!sensor.convert_request(true)) return;
+  delay(sensor.conversion_time());
+
+  for (uint8_t handle = 0; handle < table.count(); handle++) {
+    sensor.rom(table, handle);
+    Serial.print(handle);
+    Serial.print(F(":temperature="));
+    if (sensor.read_scratchpad())
+      Serial.println(sensor.temperature_centi());
+    else
+      Serial.println(F("--"));
+  }
+  Serial.println();
+  delay(2000);
+}
@@ -0,0 +1,55 @@
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Driver/DS18B20.h"
+#include "assert.h"
+
+Software::OWI<BOARD::D7> owi;
+DS18B20 sensor(owi);
+
+void setup()
+{
+  Serial.begin(57600);
+  while (!Serial);
+
+  // Read all thermometer sensors and set an alarm trigger window
+  // (+-1 C) around the current temperature
+  ASSERT(sensor.convert_request(true));
+  delay(sensor.conversion_time());
+  uint8_t* rom = sensor.rom();
+  int8_t last = owi.FIRST;
+  do {
+    last = owi.search_rom(sensor.FAMILY_CODE, rom, last);
+    if (last == owi.ERROR) break;
+    ASSERT(sensor.read_scratchpad(false));
+    ASSERT(sensor.window());
+  } while (last != owi.LAST);
+}
+
+void loop()
+{
+  // Broadcast a convert request and use alarm search to read only
+  // the sensors with changed temperature. Print timestamp, sensor
+  // identity (rom) and temperature. The trigger window is moved to
+  // the new temperature
+
+  static uint16_t timestamp = 0;
+  int8_t last = owi.FIRST;
+  uint8_t* rom = sensor.rom();
+  if (!sensor.convert_request(true)) return;
+  delay(sensor.conversion_time());
+  do {
+    last = sensor.alarm_update(last);
+    if (last == owi.ERROR) break;
+    Serial.print(timestamp);
+    Serial.print(F(":rom="));
+    for (size_t i = 0; i < owi.ROM_MAX; i++) {
+      if (rom[i] < 0x10) Serial.print(0);
+      Serial.print(rom[i], HEX);
+    }
+    Serial.print(F(",temperature="));
+    Serial.println(sensor.temperature());
+  } while (last != owi.LAST);
+  timestamp += 1;
+  delay(1000);
+}
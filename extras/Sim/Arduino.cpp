@@ -0,0 +1,53 @@
+/**
+ * @file Arduino.cpp
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * @section Description
+ * Co-simulation of the Remote Arduino example sketch (master) with
+ * the Remote Arduino slave sketch (examples/Slave/Arduino) on a
+ * virtual wire (D7). The sketches are compiled unmodified. The master
+ * prints the remote pin values and the virtual time (us) of remote
+ * digitalWrite(); the remote I/O throughput.
+ * Usage: Arduino [seconds]
+ */
+
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Slave/OWI.h"
+#include "Driver/Arduino.h"
+#include "assert.h"
+#include "benchmark.h"
+
+namespace master {
+#include "../../examples/Arduino/Arduino.ino"
+};
+
+namespace slave {
+#include "../../examples/Slave/Arduino/Arduino.ino"
+};
+
+int main(int argc, char* argv[])
+{
+  Sim::Kernel& sim = Sim::kernel();
+  uint64_t seconds = (argc > 1) ? atoi(argv[1]) : 5;
+  sim.wire(BOARD::D7);
+  sim.node("master", master::setup, master::loop);
+  Sim::node_t& board = sim.node("slave", slave::setup, slave::loop);
+  board.digital = 0x5555;
+  for (uint8_t i = 0; i < Sim::ANALOG_MAX; i++) board.analog[i] = 100 * i;
+  sim.run(seconds * 1000000);
+}
@@ -0,0 +1,316 @@
+/**
+ * @file Arduino.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "Sim.h"
+
+/**
+ * Host replacement of the Arduino core functions used by the library
+ * and example sketches. Timing functions use the virtual clock of the
+ * calling node (see Sim.h); board functions (EEPROM, analog and
+ * digital pins) use the emulated board of the node. Serial output is
+ * written to standard output. The min() and max() macros are defined
+ * as in the AVR core.
+ */
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define NUM_DIGITAL_PINS 20
+#define NUM_ANALOG_INPUTS 6
+#define LED_BUILTIN 13
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+
+#define PROGMEM
+#define EEMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t*) (addr))
+#define pgm_read_word(addr) (*(const uint16_t*) (addr))
+#define pgm_read_dword(addr) (*(const uint32_t*) (addr))
+#define pgm_read_ptr(addr) (*(void* const*) (addr))
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+#define strlen_P strlen
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper*) (s))
+
+inline unsigned long micros()
+{
+  return (Sim::kernel().time() / 1000);
+}
+
+inline unsigned long millis()
+{
+  return (Sim::kernel().time() / 1000000);
+}
+
+inline void delayMicroseconds(unsigned int us)
+{
+  Sim::kernel().delay(us * 1000ULL);
+}
+
+inline void delay(unsigned long ms)
+{
+  Sim::kernel().delay(ms * 1000000ULL);
+}
+
+inline void yield()
+{
+  if (Sim::Kernel::self() == NULL)
+    std::this_thread::yield();
+  else
+    Sim::kernel().delay(Sim::YIELD_COST);
+}
+
+inline void noInterrupts()
+{
+}
+
+inline void interrupts()
+{
+}
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+  (void) pin;
+  (void) mode;
+}
+
+inline int digitalRead(uint8_t pin)
+{
+  return ((Sim::kernel().board().digital >> (pin & 31)) & 1);
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value)
+{
+  Sim::node_t& board = Sim::kernel().board();
+  if (value)
+    board.digital |= (1UL << (pin & 31));
+  else
+    board.digital &= ~(1UL << (pin & 31));
+}
+
+inline int analogRead(uint8_t pin)
+{
+  if (pin >= A0) pin -= A0;
+  return (Sim::kernel().board().analog[pin % Sim::ANALOG_MAX]);
+}
+
+inline void analogWrite(uint8_t pin, int duty)
+{
+  (void) pin;
+  (void) duty;
+}
+
+/**
+ * Pseudo-random numbers; shared deterministic generator so that
+ * sketch instances get different random values also during static
+ * initialization.
+ */
+inline uint32_t& random_state()
+{
+  static uint32_t state = 2463534242UL;
+  return (state);
+}
+
+inline void randomSeed(unsigned long seed)
+{
+  if (seed != 0) random_state() = seed;
+}
+
+inline long random(long max)
+{
+  uint32_t& x = random_state();
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return (max <= 0 ? 0 : (long) (x % max));
+}
+
+inline long random(long min, long max)
+{
+  return (min >= max ? min : min + random(max - min));
+}
+
+inline uint8_t eeprom_read_byte(const uint8_t* addr)
+{
+  return (Sim::kernel().board().eeprom[(uintptr_t) addr % Sim::EEPROM_MAX]);
+}
+
+inline void eeprom_write_byte(uint8_t* addr, uint8_t value)
+{
+  Sim::kernel().board().eeprom[(uintptr_t) addr % Sim::EEPROM_MAX] = value;
+}
+
+inline void eeprom_read_block(void* dest, const void* src, size_t count)
+{
+  uint8_t* dp = (uint8_t*) dest;
+  const uint8_t* sp = (const uint8_t*) src;
+  while (count--) *dp++ = eeprom_read_byte(sp++);
+}
+
+inline void eeprom_write_block(const void* src, void* dest, size_t count)
+{
+  const uint8_t* sp = (const uint8_t*) src;
+  uint8_t* dp = (uint8_t*) dest;
+  while (count--) eeprom_write_byte(dp++, *sp++);
+}
+
+inline void eeprom_update_block(const void* src, void* dest, size_t count)
+{
+  eeprom_write_block(src, dest, count);
+}
+
+/**
+ * Print; formatted output of numbers and strings to a byte sink.
+ */
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+
+  virtual size_t write(const uint8_t* buf, size_t size)
+  {
+    size_t n = 0;
+    while (size--) n += write(*buf++);
+    return (n);
+  }
+
+  size_t write(const char* s)
+  {
+    return (write((const uint8_t*) s, strlen(s)));
+  }
+
+  size_t print(const __FlashStringHelper* s) { return (write((const char*) s)); }
+  size_t print(const char* s) { return (write(s)); }
+  size_t print(char c) { return (write((uint8_t) c)); }
+  size_t print(unsigned char n, int base = DEC) { return (print((unsigned long) n, base)); }
+  size_t print(int n, int base = DEC) { return (print((long) n, base)); }
+  size_t print(unsigned int n, int base = DEC) { return (print((unsigned long) n, base)); }
+
+  size_t print(long n, int base = DEC)
+  {
+    if (base == DEC && n < 0) return (print('-') + number(-(unsigned long) n, DEC));
+    return (number(n, base));
+  }
+
+  size_t print(unsigned long n, int base = DEC)
+  {
+    return (number(n, base));
+  }
+
+  size_t print(double n, int digits = 2)
+  {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return (write(buf));
+  }
+
+  size_t println() { return (write("\n")); }
+
+  template<typename T>
+  size_t println(T value)
+  {
+    size_t n = print(value);
+    return (n + println());
+  }
+
+  template<typename T>
+  size_t println(T value, int base)
+  {
+    size_t n = print(value, base);
+    return (n + println());
+  }
+
+protected:
+  size_t number(unsigned long n, int base)
+  {
+    char buf[8 * sizeof(long) + 1];
+    char* bp = &buf[sizeof(buf) - 1];
+    if (base < 2) base = DEC;
+    *bp = 0;
+    do {
+      unsigned long digit = n % base;
+      n /= base;
+      *--bp = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    } while (n != 0);
+    return (write(bp));
+  }
+};
+
+/**
+ * Stream; input interface.
+ */
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() {}
+};
+
+/**
+ * Serial port. The default instance (Serial) writes to standard
+ * output. Host serial ports override begin() and the stream
+ * functions, e.g. Termios.
+ */
+class HardwareSerial : public Stream {
+public:
+  virtual void begin(unsigned long baudrate) { (void) baudrate; }
+  virtual void end() {}
+  virtual int available() { return (0); }
+  virtual int read() { return (-1); }
+  virtual int peek() { return (-1); }
+  virtual void flush() { fflush(stdout); }
+  virtual int availableForWrite() { return (64); }
+  virtual size_t write(uint8_t c) { return (fputc(c, stdout) == EOF ? 0 : 1); }
+  using Print::write;
+  operator bool() { return (true); }
+};
+
+/** Sketch serial port; standard output. */
+static HardwareSerial Serial;
+#endif
@@ -0,0 +1,53 @@
+/**
+ * @file DS18B20.cpp
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * @section Description
+ * Co-simulation of the DS18B20 example sketch (master) with two
+ * emulated DS18B20 slave devices (examples/Slave/DS18B20) on the
+ * same virtual wire (D7). The sketches are compiled unmodified.
+ * Usage: DS18B20 [seconds]
+ */
+
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Slave/OWI.h"
+#include "Driver/DS18B20.h"
+#include "assert.h"
+
+namespace master {
+#include "../../examples/DS18B20/DS18B20.ino"
+};
+
+namespace slave1 {
+#include "../../examples/Slave/DS18B20/DS18B20.ino"
+};
+
+namespace slave2 {
+#include "../../examples/Slave/DS18B20/DS18B20.ino"
+};
+
+int main(int argc, char* argv[])
+{
+  Sim::Kernel& sim = Sim::kernel();
+  uint64_t seconds = (argc > 1) ? atoi(argv[1]) : 5;
+  sim.wire(BOARD::D7);
+  sim.node("master", master::setup, master::loop);
+  sim.node("slave1", slave1::setup, slave1::loop).analog[0] = 600;
+  sim.node("slave2", slave2::setup, slave2::loop).analog[0] = 400;
+  sim.run(seconds * 1000000);
+}
@@ -0,0 +1,258 @@
+/**
+ * @file DS2480B.cpp
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * @section Description
+ * Host test of the DS2480B serial line driver bus manager
+ * (UART::DS2480B) on a pseudo terminal (Termios). An adapter thread
+ * emulates the DS2480B command and data mode protocol, and the search
+ * accelerator, with emulated devices (Emulator). Verifies the line
+ * speed of each byte, reset, bit, byte and block transfers (transfer
+ * with check sum), and search. Also verifies that the search
+ * accelerator and pipelined block transfers are used through the
+ * shared bus manager (Shared::OWI). Fails on protocol errors or wrong
+ * results.
+ * Usage: DS2480B [iterations]
+ */
+
+#include <atomic>
+#include <thread>
+#include "GPIO.h"
+#include "OWI.h"
+#include "UART/DS2480B.h"
+#include "Shared/OWI.h"
+#include "Termios.h"
+#include "Emulator.h"
+
+Termios serial;
+Sim::Emulator bus;
+UART::DS2480B owi(serial);
+Shared::OWI shared(owi);
+std::atomic<bool> running;
+
+/** Adapter statistics; bytes received, accelerator and errors. */
+uint32_t bytes = 0;
+uint32_t accelerated = 0;
+uint32_t errors = 0;
+
+/**
+ * DS2480B adapter emulation; command and data mode, reset, single
+ * bit and search accelerator commands at 9600 baud. A zero byte at
+ * 4800 baud is a break; the next byte is the timing byte.
+ */
+void adapter()
+{
+  uint8_t mode = UART::DS2480B::COMMAND_MODE;
+  bool accelerator = false;
+  bool timing = false;
+  bool escape = false;
+  while (running) {
+    uint32_t baudrate;
+    int c = serial.recv(baudrate, 10);
+    if (c < 0) continue;
+    bytes += 1;
+    if (baudrate == UART::DS2480B::BREAK_BAUDRATE && c == 0) {
+      mode = UART::DS2480B::COMMAND_MODE;
+      accelerator = false;
+      timing = true;
+      continue;
+    }
+    if (baudrate != UART::DS2480B::BAUDRATE) {
+      errors += 1;
+      continue;
+    }
+    if (timing) {
+      timing = false;
+      continue;
+    }
+    if (mode == UART::DS2480B::DATA_MODE) {
+      if (c == UART::DS2480B::COMMAND_MODE && !escape) {
+	escape = true;
+	continue;
+      }
+      if (!escape || c == UART::DS2480B::COMMAND_MODE) {
+	escape = false;
+	uint8_t res = 0;
+	if (accelerator) {
+	  for (uint8_t i = 0; i < 8; i += 2) {
+	    bool a = bus.slot(1);
+	    bool b = bus.slot(1);
+	    bool dir = (c >> (i + 1)) & 1;
+	    if (a != b) dir = a;
+	    else res |= (1 << i);
+	    bus.slot(dir);
+	    if (dir) res |= (2 << i);
+	  }
+	}
+	else {
+	  for (uint8_t i = 0; i < 8; i++)
+	    if (bus.slot((c >> i) & 1)) res |= (1 << i);
+	}
+	serial.send(res);
+	continue;
+      }
+      escape = false;
+      mode = UART::DS2480B::COMMAND_MODE;
+    }
+    switch (c) {
+    case UART::DS2480B::DATA_MODE:
+      mode = UART::DS2480B::DATA_MODE;
+      break;
+    case UART::DS2480B::COMMAND_MODE:
+      break;
+    case UART::DS2480B::RESET:
+      serial.send(0xcc | (bus.reset() ?
+			  UART::DS2480B::RESET_PRESENCE :
+			  UART::DS2480B::RESET_NO_PRESENCE));
+      break;
+    case UART::DS2480B::SINGLE_BIT:
+    case UART::DS2480B::SINGLE_BIT | UART::DS2480B::BIT_ONE:
+      serial.send((c & 0xfc) |
+		  (bus.slot(c & UART::DS2480B::BIT_ONE) ? 0x03 : 0x00));
+      break;
+    case UART::DS2480B::SEARCH_ON:
+      accelerated += 1;
+      accelerator = true;
+      break;
+    case UART::DS2480B::SEARCH_OFF:
+      accelerator = false;
+      break;
+    default:
+      errors += 1;
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  int iterations = (argc > 1) ? atoi(argv[1]) : 100;
+  int status = 0;
+
+  if (!serial.open()) {
+    perror("pty");
+    return (1);
+  }
+  running = true;
+  std::thread thread(adapter);
+  owi.begin();
+
+  // Empty bus
+  if (owi.reset()) status = 1;
+  owi.backoff_clear();
+
+  // Devices; rom with escaped mode switch byte (0xe3)
+  bus.add(0x28, 0x010203);
+  bus.add(0x28, 0xe3e3e3);
+  bus.add(0x10, 0x0a0b0c);
+
+  // Search; all devices found once
+  int found = 0;
+  for (int i = 0; i < iterations; i++) {
+    uint8_t rom[OWI::ROM_MAX] = { 0 };
+    int8_t last = OWI::FIRST;
+    uint8_t n = 0;
+    do {
+      last = owi.search_rom(0, rom, last);
+      if (last == OWI::ERROR) break;
+      for (uint8_t j = 0; j < bus.devices(); j++)
+	if (!memcmp(rom, bus.device(j).rom, sizeof(rom))) n += 1;
+    } while (last != OWI::LAST);
+    if (n == bus.devices()) found += 1;
+  }
+  printf("search:found=%d/%d\n", found, iterations);
+  if (found != iterations) status = 1;
+
+  // Write and read scratchpad; transfer with check sum
+  int passed = 0;
+  for (int i = 0; i < iterations; i++) {
+    Sim::device_t& dev = bus.device(i % bus.devices());
+    uint8_t config[3] = { (uint8_t) i, (uint8_t) ~i, 0x1f };
+    uint8_t cmd = 0x4e;
+    OWI::segment_t wr[] = {
+      { OWI::TX_WRITE, sizeof(cmd), &cmd },
+      { OWI::TX_WRITE, sizeof(config), config }
+    };
+    uint8_t sp[8];
+    bool ok = owi.match_rom(dev.rom) && owi.transfer(wr, 2);
+    cmd = 0xbe;
+    OWI::segment_t rd[] = {
+      { OWI::TX_WRITE, sizeof(cmd), &cmd },
+      { OWI::TX_READ | OWI::TX_CRC8 | OWI::TX_RESTART, sizeof(sp), sp },
+      { OWI::TX_CHECK | OWI::TX_CRC8, 0, NULL }
+    };
+    ok = ok && owi.match_rom(dev.rom) && owi.transfer(rd, 3);
+    if (ok && !memcmp(&sp[2], config, sizeof(config))) passed += 1;
+  }
+  printf("scratchpad:passed=%d/%d\n", passed, iterations);
+  if (passed != iterations) status = 1;
+
+  // Bit transfers in command mode; read rom is the wired-and
+  uint8_t rom[OWI::ROM_MAX];
+  uint8_t expected[OWI::ROM_MAX];
+  memset(expected, 0xff, sizeof(expected));
+  for (uint8_t j = 0; j < bus.devices(); j++)
+    for (uint8_t i = 0; i < sizeof(rom); i++) expected[i] &= bus.device(j).rom[i];
+  bool ok = owi.reset();
+  owi.write(0x33 & 0x0f, 4);
+  owi.write(0x33 >> 4, 4);
+  for (uint8_t i = 0; i < sizeof(rom); i++) rom[i] = owi.read(3) | (owi.read(5) << 3);
+  ok = ok && !memcmp(rom, expected, sizeof(rom));
+  printf("bits:%s\n", ok ? "passed" : "failed");
+  if (!ok) status = 1;
+
+  // Shared bus manager; search accelerator and pipelined block read
+  found = 0;
+  accelerated = 0;
+  for (int i = 0; i < iterations; i++) {
+    uint8_t rom[OWI::ROM_MAX] = { 0 };
+    int8_t last = OWI::FIRST;
+    uint8_t n = 0;
+    do {
+      last = shared.search_rom(0, rom, last);
+      if (last == OWI::ERROR) break;
+      n += 1;
+    } while (last != OWI::LAST);
+    if (n == bus.devices()) found += 1;
+  }
+  passed = 0;
+  size_t in_flight = 0;
+  for (int i = 0; i < iterations; i++) {
+    Sim::device_t& dev = bus.device(i % bus.devices());
+    uint8_t sp[9];
+    if (!shared.match_rom(dev.rom)) continue;
+    shared.write(0xbe);
+    serial.flush();
+    serial.in_flight = 0;
+    ok = shared.read(sp, sizeof(sp));
+    if (serial.in_flight > in_flight) in_flight = serial.in_flight;
+    if (ok && !memcmp(sp, dev.scratchpad, sizeof(sp))) passed += 1;
+  }
+  printf("shared:found=%d/%d,accelerated=%u,passed=%d/%d,in_flight=%zu\n",
+	 found, iterations, accelerated, passed, iterations, in_flight);
+  if (found != iterations
+      || accelerated < (uint32_t) iterations * bus.devices()
+      || passed != iterations
+      || in_flight <= 1)
+    status = 1;
+
+  running = false;
+  thread.join();
+  printf("adapter:bytes=%u,resets=%u,slots=%u,errors=%u\n",
+	 bytes, bus.resets, bus.slots, errors);
+  if (errors != 0) status = 1;
+  printf("ds2480b:%s\n", status ? "failed" : "passed");
+  return (status);
+}
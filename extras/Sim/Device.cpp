@@ -0,0 +1,162 @@
+/**
+ * @file Device.cpp
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * @section Description
+ * Co-simulation of the slave device framework example
+ * (examples/Slave/Device) with a software master. Verifies the
+ * generic read and write memory commands; data and check sum over
+ * data only, the 2-bit write result, rejection of writes to
+ * read-only and program memory regions, with wrong check sum, and
+ * outside the region or region table, and that reads outside the
+ * region are ignored. Also verifies that function commands are
+ * handled after rejected memory commands. Fails on assert.
+ * Usage: Device [rounds]
+ */
+
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Slave/OWI.h"
+#include "Slave/Device.h"
+#include "assert.h"
+
+namespace slave {
+#include "../../examples/Slave/Device/Device.ino"
+};
+
+namespace master {
+Software::OWI<BOARD::D7> owi;
+int rounds = 4;
+
+/** Region index in the example region table. */
+enum { SCRATCHPAD, CONFIG, NAME, REGIONS };
+
+/**
+ * Issue read memory command and read data and check sum to given
+ * buffer. Returns true(1) if the check sum is correct.
+ */
+bool read_memory(uint8_t ix, uint16_t offset, uint8_t count, uint8_t* buf)
+{
+  ASSERT(owi.reset());
+  owi.write(OWI::SKIP_ROM);
+  uint8_t param[] = { ix, (uint8_t) offset, (uint8_t) (offset >> 8), count };
+  owi.write(slave::Device::READ_MEMORY, param, sizeof(param));
+  return (owi.read(buf, count + 1));
+}
+
+/**
+ * Issue write memory command with data and given check sum. Returns
+ * the 2-bit result.
+ */
+uint8_t write_memory(uint8_t ix, uint16_t offset, uint8_t count,
+		     const uint8_t* buf, uint8_t crc)
+{
+  ASSERT(owi.reset());
+  owi.write(OWI::SKIP_ROM);
+  uint8_t param[] = { ix, (uint8_t) offset, (uint8_t) (offset >> 8), count };
+  owi.write(slave::Device::WRITE_MEMORY, param, sizeof(param));
+  while (count--) owi.write(*buf++);
+  owi.write(crc);
+  return (owi.read(2));
+}
+
+/**
+ * Check that all bytes in buffer are ones; not driven by the slave.
+ */
+bool ignored(const uint8_t* buf, uint8_t count)
+{
+  while (count--) if (*buf++ != 0xff) return (false);
+  return (true);
+}
+
+void setup()
+{
+  delay(10);
+}
+
+void loop()
+{
+  static int round = 0;
+  uint8_t buf[slave::Device::BUF_MAX + 1];
+  uint8_t data[8];
+  uint8_t config[sizeof(slave::config)];
+  uint8_t sp[sizeof(slave::scratchpad_t)];
+  for (uint8_t i = 0; i < sizeof(data); i++) data[i] = round * 16 + i;
+  memcpy(config, slave::config, sizeof(config));
+  memcpy(sp, &slave::scratchpad, sizeof(sp));
+
+  // Read data memory and program memory; check sum over data only
+  ASSERT(read_memory(SCRATCHPAD, 0, sizeof(sp), buf));
+  ASSERT(!memcmp(buf, sp, sizeof(sp)));
+  ASSERT(buf[sizeof(sp)] == OWI::crc(sp, sizeof(sp)));
+  ASSERT(read_memory(NAME, 0, sizeof(slave::name), buf));
+  ASSERT(!strcmp((const char*) buf, slave::name));
+  ASSERT(read_memory(NAME, 8, 4, buf));
+  ASSERT(!memcmp(buf, &slave::name[8], 4));
+  ASSERT(read_memory(CONFIG, sizeof(config), 0, buf) && buf[0] == 0);
+
+  // Write memory; result and data written
+  ASSERT(write_memory(CONFIG, 4, sizeof(data), data,
+		      OWI::crc(data, sizeof(data))) == 0b10);
+  memcpy(&config[4], data, sizeof(data));
+  ASSERT(!memcmp(slave::config, config, sizeof(config)));
+  ASSERT(read_memory(CONFIG, 4, sizeof(data), buf));
+  ASSERT(!memcmp(buf, data, sizeof(data)));
+
+  // Rejected writes; check sum error, read-only and program memory,
+  // outside region and region table
+  uint8_t crc = OWI::crc(data, sizeof(data));
+  ASSERT(write_memory(CONFIG, 0, sizeof(data), data, crc ^ 1) == 0b00);
+  ASSERT(write_memory(SCRATCHPAD, 0, sizeof(data), data, crc) == 0b00);
+  ASSERT(write_memory(NAME, 0, sizeof(data), data, crc) == 0b00);
+  ASSERT(write_memory(CONFIG, sizeof(config) - 4, sizeof(data), data, crc)
+	 == 0b00);
+  ASSERT(write_memory(CONFIG, 0xfff0, sizeof(data), data, crc) == 0b00);
+  ASSERT(write_memory(REGIONS, 0, sizeof(data), data, crc) == 0b00);
+  ASSERT(!memcmp(slave::config, config, sizeof(config)));
+  ASSERT(!memcmp(&slave::scratchpad, sp, sizeof(sp)));
+
+  // Ignored reads; outside region and region table
+  ASSERT(!read_memory(CONFIG, sizeof(config) - 4, 8, buf));
+  ASSERT(ignored(buf, 9));
+  ASSERT(!read_memory(SCRATCHPAD, 0, sizeof(sp) + 1, buf));
+  ASSERT(ignored(buf, sizeof(sp) + 2));
+  ASSERT(!read_memory(REGIONS, 0, 1, buf));
+  ASSERT(ignored(buf, 2));
+
+  // Function command after rejected memory commands
+  ASSERT(owi.reset());
+  owi.write(OWI::SKIP_ROM);
+  owi.write(slave::READ_SCRATCHPAD);
+  ASSERT(owi.read(buf, sizeof(sp) + 1));
+  ASSERT(!memcmp(buf, sp, sizeof(sp)));
+
+  printf("device:round=%d\n", round);
+  if (++round == rounds) Sim::kernel().stop(0);
+  delay(1);
+}
+};
+
+int main(int argc, char* argv[])
+{
+  Sim::Kernel& sim = Sim::kernel();
+  if (argc > 1) master::rounds = atoi(argv[1]);
+  sim.wire(BOARD::D7);
+  sim.node("master", master::setup, master::loop);
+  sim.node("slave", slave::setup, slave::loop);
+  sim.run(1000000);
+}
@@ -0,0 +1,329 @@
+/**
+ * @file Emulator.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SIM_EMULATOR_H
+#define SIM_EMULATOR_H
+
+#include <stdint.h>
+#include <string.h>
+
+namespace Sim {
+/**
+ * Emulated 1-Wire device; rom code and DS18B20 style scratchpad
+ * (temperature, alarm thresholds, configuration and check sum).
+ */
+struct device_t {
+  uint8_t rom[8];		//!< Rom code; family, serial and check sum.
+  uint8_t scratchpad[9];	//!< Scratchpad and check sum.
+  bool selected;		//!< Selected by rom command.
+};
+
+/**
+ * Emulated 1-Wire bus with a set of devices at time slot level; a
+ * bus adapter emulator calls reset() for each reset pulse and slot()
+ * for each time slot. The devices answer the rom commands (read,
+ * match, skip and search rom), and read and write scratchpad. The
+ * bus is the wired-and of the master and the selected devices.
+ */
+class Emulator {
+public:
+  /** Max number of devices. */
+  static const uint8_t DEVICE_MAX = 8;
+
+  Emulator() :
+    resets(0),
+    slots(0),
+    m_devices(0),
+    m_state(IDLE)
+  {
+  }
+
+  /**
+   * Add device with given family code and serial number. The rom
+   * check sum and scratchpad are generated.
+   * @param[in] family code.
+   * @param[in] serial number.
+   * @return device.
+   */
+  device_t& add(uint8_t family, uint32_t serial)
+  {
+    device_t& dev = m_device[m_devices++];
+    memset(&dev, 0, sizeof(dev));
+    dev.rom[0] = family;
+    for (uint8_t i = 1; i < 7; i++, serial >>= 8) dev.rom[i] = serial;
+    dev.rom[7] = crc(dev.rom, 7);
+    dev.scratchpad[0] = serial;
+    dev.scratchpad[1] = m_devices;
+    dev.scratchpad[4] = 0x7f;
+    dev.scratchpad[8] = crc(dev.scratchpad, 8);
+    return (dev);
+  }
+
+  /**
+   * Remove device with given index.
+   * @param[in] ix device index.
+   */
+  void remove(uint8_t ix)
+  {
+    m_devices -= 1;
+    memmove(&m_device[ix], &m_device[ix + 1],
+	    (m_devices - ix) * sizeof(device_t));
+  }
+
+  /**
+   * Return number of devices.
+   * @return devices.
+   */
+  uint8_t devices() const
+  {
+    return (m_devices);
+  }
+
+  /**
+   * Return device with given index.
+   * @param[in] ix device index.
+   * @return device.
+   */
+  device_t& device(uint8_t ix)
+  {
+    return (m_device[ix]);
+  }
+
+  /**
+   * Reset pulse; all devices are selected and wait for a rom
+   * command. Returns true(1) if there are devices to generate a
+   * presence pulse, otherwise false(0).
+   * @return bool.
+   */
+  bool reset()
+  {
+    resets += 1;
+    for (uint8_t i = 0; i < m_devices; i++) m_device[i].selected = true;
+    begin(m_devices != 0 ? ROM_COMMAND : IDLE);
+    return (m_devices != 0);
+  }
+
+  /**
+   * Time slot; the master writes given bit (one for read slots). The
+   * selected devices write or read the bit according to state.
+   * Returns the bus level.
+   * @param[in] bit written by master.
+   * @return bus level.
+   */
+  bool slot(bool bit)
+  {
+    slots += 1;
+    switch (m_state) {
+    case ROM_COMMAND:
+      if (shift(bit)) {
+	switch (m_byte) {
+	case READ_ROM: begin(READ_ROM); break;
+	case MATCH_ROM: begin(MATCH_ROM); break;
+	case SKIP_ROM: begin(FUNCTION); break;
+	case SEARCH_ROM: begin(SEARCH_ROM); break;
+	default: begin(IDLE);
+	}
+      }
+      return (bit);
+    case READ_ROM:
+      bit = bit && level(m_bit, false);
+      if (++m_bit == 64) begin(FUNCTION);
+      return (bit);
+    case MATCH_ROM:
+      deselect(m_bit, bit);
+      if (++m_bit == 64) begin(FUNCTION);
+      return (bit);
+    case SEARCH_ROM:
+      switch (m_phase) {
+      case 0:
+	bit = bit && level(m_bit, false);
+	break;
+      case 1:
+	bit = bit && level(m_bit, true);
+	break;
+      case 2:
+	deselect(m_bit, bit);
+	m_phase = 0;
+	if (++m_bit == 64) begin(FUNCTION);
+	return (bit);
+      }
+      m_phase += 1;
+      return (bit);
+    case FUNCTION:
+      if (shift(bit)) {
+	switch (m_byte) {
+	case READ_SCRATCHPAD: begin(READ_SCRATCHPAD); break;
+	case WRITE_SCRATCHPAD: begin(WRITE_SCRATCHPAD); break;
+	default: begin(IDLE);
+	}
+      }
+      return (bit);
+    case READ_SCRATCHPAD:
+      bit = bit && scratchpad(m_bit);
+      if (++m_bit == 72) begin(IDLE);
+      return (bit);
+    case WRITE_SCRATCHPAD:
+      if (shift(bit)) {
+	for (uint8_t i = 0; i < m_devices; i++) {
+	  device_t& dev = m_device[i];
+	  if (!dev.selected) continue;
+	  dev.scratchpad[2 + m_bit / 8 - 1] = m_byte;
+	  dev.scratchpad[8] = crc(dev.scratchpad, 8);
+	}
+	if (m_bit == 24) begin(IDLE);
+      }
+      return (bit);
+    default:
+      return (bit);
+    }
+  }
+
+  /**
+   * 1-Wire check sum (CRC8, polynomial 0x8c reflected).
+   * @param[in] buf buffer.
+   * @param[in] count number of bytes.
+   * @return check sum.
+   */
+  static uint8_t crc(const uint8_t* buf, uint8_t count)
+  {
+    uint8_t res = 0;
+    while (count--) {
+      res ^= *buf++;
+      for (uint8_t i = 0; i < 8; i++)
+	res = (res & 1) ? (res >> 1) ^ 0x8c : (res >> 1);
+    }
+    return (res);
+  }
+
+  /** Number of reset pulses. */
+  uint32_t resets;
+
+  /** Number of time slots. */
+  uint32_t slots;
+
+protected:
+  /**
+   * Rom and function commands.
+   */
+  enum {
+    READ_ROM = 0x33,
+    MATCH_ROM = 0x55,
+    SKIP_ROM = 0xcc,
+    SEARCH_ROM = 0xf0,
+    READ_SCRATCHPAD = 0xbe,
+    WRITE_SCRATCHPAD = 0x4e
+  } __attribute__((packed));
+
+  /**
+   * Bus states; idle, or receiving or executing command.
+   */
+  enum {
+    IDLE,
+    ROM_COMMAND,
+    FUNCTION
+  } __attribute__((packed));
+
+  /** Devices. */
+  device_t m_device[DEVICE_MAX];
+  uint8_t m_devices;
+
+  /** State; idle, command, or rom/function command in progress. */
+  uint8_t m_state;
+
+  /** Bit position within command. */
+  uint8_t m_bit;
+
+  /** Search time slot within rom bit position. */
+  uint8_t m_phase;
+
+  /** Byte received. */
+  uint8_t m_byte;
+
+  /**
+   * Start given state.
+   * @param[in] state next state.
+   */
+  void begin(uint8_t state)
+  {
+    m_state = state;
+    m_bit = 0;
+    m_phase = 0;
+    m_byte = 0;
+  }
+
+  /**
+   * Shift given bit into byte; LSB first. Returns true(1) when a
+   * byte has been received.
+   * @param[in] bit received.
+   * @return bool.
+   */
+  bool shift(bool bit)
+  {
+    m_byte = (m_byte >> 1) | (bit ? 0x80 : 0);
+    return ((++m_bit & 0x07) == 0);
+  }
+
+  /**
+   * Wired-and of given rom bit, or complement, of the selected
+   * devices.
+   * @param[in] pos rom bit position.
+   * @param[in] complement bit.
+   * @return bus level.
+   */
+  bool level(uint8_t pos, bool complement)
+  {
+    for (uint8_t i = 0; i < m_devices; i++) {
+      device_t& dev = m_device[i];
+      if (!dev.selected) continue;
+      bool bit = (dev.rom[pos / 8] >> (pos & 0x07)) & 1;
+      if (bit == complement) return (false);
+    }
+    return (true);
+  }
+
+  /**
+   * Deselect devices with rom bit not equal to given bit.
+   * @param[in] pos rom bit position.
+   * @param[in] bit selected.
+   */
+  void deselect(uint8_t pos, bool bit)
+  {
+    for (uint8_t i = 0; i < m_devices; i++) {
+      device_t& dev = m_device[i];
+      if (((dev.rom[pos / 8] >> (pos & 0x07)) & 1) != bit)
+	dev.selected = false;
+    }
+  }
+
+  /**
+   * Wired-and of given scratchpad bit of the selected devices.
+   * @param[in] pos scratchpad bit position.
+   * @return bus level.
+   */
+  bool scratchpad(uint8_t pos)
+  {
+    for (uint8_t i = 0; i < m_devices; i++) {
+      device_t& dev = m_device[i];
+      if (dev.selected && !((dev.scratchpad[pos / 8] >> (pos & 0x07)) & 1))
+	return (false);
+    }
+    return (true);
+  }
+};
+};
+#endif
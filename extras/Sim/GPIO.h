@@ -0,0 +1,112 @@
+/**
+ * @file GPIO.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SIM_GPIO_H
+#define SIM_GPIO_H
+
+#include "Arduino.h"
+
+/**
+ * Board pin numbers; each pin is a virtual wire shared by all nodes.
+ */
+namespace BOARD {
+  enum pin_t {
+    D0, D1, D2, D3, D4, D5, D6, D7, D8, D9,
+    D10, D11, D12, D13, D14, D15, D16, D17, D18, D19,
+    D20, D21, D22, D23, D24, D25, D26, D27, D28, D29,
+    D30, D31
+  } __attribute__((packed));
+};
+
+/**
+ * Host replacement of the GPIO template class (Arduino-GPIO). The pin
+ * is a virtual open drain wire; see Sim.h. Output high drives the
+ * wire high (push-pull), output low pulls the wire low, and input
+ * releases the wire (pullup). Each access takes virtual time.
+ * @param[in] PIN board pin.
+ */
+template<BOARD::pin_t PIN>
+class GPIO {
+public:
+  void input()
+  {
+    Sim::kernel().write(PIN, false, latch());
+  }
+
+  void input_pullup()
+  {
+    Sim::kernel().write(PIN, false, true);
+  }
+
+  void output()
+  {
+    Sim::kernel().write(PIN, true, latch());
+  }
+
+  void open_drain()
+  {
+    Sim::kernel().write(PIN, false, false);
+  }
+
+  bool read()
+  {
+    return (Sim::kernel().read(PIN));
+  }
+
+  void write(int value)
+  {
+    bool output, latch;
+    Sim::kernel().mode(PIN, output, latch);
+    Sim::kernel().write(PIN, output, value != 0);
+  }
+
+  void high()
+  {
+    write(1);
+  }
+
+  void low()
+  {
+    write(0);
+  }
+
+  void toggle()
+  {
+    write(!latch());
+  }
+
+  GPIO<PIN>& operator=(int value)
+  {
+    write(value);
+    return (*this);
+  }
+
+  operator bool()
+  {
+    return (read());
+  }
+
+protected:
+  bool latch()
+  {
+    bool output, latch;
+    Sim::kernel().mode(PIN, output, latch);
+    return (latch);
+  }
+};
+#endif
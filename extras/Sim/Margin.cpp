@@ -0,0 +1,116 @@
+/**
+ * @file Margin.cpp
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * @section Description
+ * Slot timing margin of the slave device (Slave::OWI) against the
+ * software master (Software::OWI). The clock scale of an emulated
+ * DS18B20 slave (examples/Slave/DS18B20) is swept; a scale above one
+ * is a slow slave clock, i.e. the slave sample point and write zero
+ * hold are later and longer. The scratchpad is read and verified a
+ * number of times for each scale. The range of scales without errors
+ * is the margin. Fails if the nominal scale has errors.
+ * Usage: Margin [tests]
+ */
+
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Slave/OWI.h"
+#include "Driver/DS18B20.h"
+#include "assert.h"
+
+namespace slave {
+#include "../../examples/Slave/DS18B20/DS18B20.ino"
+};
+
+namespace master {
+Software::OWI<BOARD::D7> owi;
+DS18B20 sensor(owi);
+
+/** Slave node, number of tests per scale, and sweep. */
+Sim::node_t* target = NULL;
+int tests = 20;
+const int SCALE_MIN = 50;
+const int SCALE_MAX = 200;
+const int SCALE_STEP = 5;
+int scale = SCALE_MIN;
+int low = 0;
+int high = 0;
+
+void setup()
+{
+  ASSERT(owi.read_rom(sensor.rom()));
+}
+
+void loop()
+{
+  // Read and verify scratchpad with given slave clock scale (percent)
+  target->scale = scale / 100.0;
+  unsigned long start;
+  int ok = 0;
+  unsigned long us = 0;
+  for (int i = 0; i < tests; i++) {
+    start = micros();
+    if (sensor.read_scratchpad() && sensor.temperature_raw() == 0x0550) {
+      us += micros() - start;
+      ok += 1;
+    }
+    else {
+      // Allow the slave to time out and return to reset detect
+      delay(Slave::OWI<BOARD::D7>::SLOT_TIMEOUT * 2);
+    }
+  }
+  if (ok != 0) us /= ok;
+  Serial.print(F("scale="));
+  Serial.print(scale / 100.0);
+  Serial.print(F(",ok="));
+  Serial.print(ok);
+  Serial.print('/');
+  Serial.print(tests);
+  Serial.print(F(",us="));
+  Serial.println(us);
+
+  // Track the range of scales without errors that includes nominal
+  if (ok == tests) {
+    if (low == 0 || high != scale - SCALE_STEP) low = scale;
+    high = scale;
+  }
+  else if (low != 0 && low <= 100 && high >= 100) {
+    scale = SCALE_MAX;
+  }
+  scale += SCALE_STEP;
+  if (scale <= SCALE_MAX) return;
+
+  // Print margin and stop
+  Serial.print(F("margin="));
+  Serial.print(low / 100.0);
+  Serial.print(F(".."));
+  Serial.println(high / 100.0);
+  ASSERT(low <= 100 && high >= 100);
+  Sim::kernel().stop(0);
+}
+};
+
+int main(int argc, char* argv[])
+{
+  Sim::Kernel& sim = Sim::kernel();
+  if (argc > 1) master::tests = atoi(argv[1]);
+  sim.wire(BOARD::D7);
+  sim.node("master", master::setup, master::loop);
+  master::target = &sim.node("slave", slave::setup, slave::loop);
+  sim.run(600000000);
+}
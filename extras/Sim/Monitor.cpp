@@ -0,0 +1,202 @@
+/**
+ * @file Monitor.cpp
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * @section Description
+ * Host test of the device change monitor (OWI::Monitor) on emulated
+ * devices (Emulator) at time slot level. Verifies arrivals and
+ * departures, the number of search passes per round, and that
+ * devices that do not fit in the table are reported once as
+ * overflow and not as arrivals each round, and that a bus adapter
+ * failure is not reported as departures. Also verifies that the
+ * search statistics count rejected rom codes separately from rom
+ * searches where no device answered. Fails on wrong results.
+ */
+
+#include "GPIO.h"
+#include "OWI.h"
+#include "Search/Monitor.h"
+#include "Emulator.h"
+
+/**
+ * Bus manager on the emulated devices; one slot per bit.
+ */
+class Bus : public OWI {
+public:
+  Bus() : presence(false), failure(false) {}
+
+  virtual bool reset()
+  {
+    if (failure) bus_state(BUS_ERROR);
+    else bus_state(emulator.reset() || presence ? BUS_PRESENT : BUS_EMPTY);
+    return (m_bus_state == BUS_PRESENT);
+  }
+
+  virtual uint8_t read(uint8_t bits = CHARBITS)
+  {
+    uint8_t res = 0;
+    for (uint8_t i = 0; i < bits; i++)
+      if (emulator.slot(1)) res |= (1 << i);
+    return (res);
+  }
+
+  virtual void write(uint8_t value, uint8_t bits = CHARBITS)
+  {
+    for (uint8_t i = 0; i < bits; i++, value >>= 1)
+      emulator.slot(value & 1);
+  }
+
+  using OWI::read;
+  using OWI::write;
+
+  /** Presence pulse without devices; e.g. device removed. */
+  bool presence;
+
+  /** Bus adapter failure on reset. */
+  bool failure;
+
+  Sim::Emulator emulator;
+};
+
+/**
+ * Monitor that counts reported arrivals and departures.
+ */
+class Counter : public OWI::Monitor {
+public:
+  Counter(OWI& owi, uint8_t (*table)[OWI::ROM_MAX], uint8_t max) :
+    OWI::Monitor(owi, table, max),
+    arrivals(0),
+    departures(0)
+  {
+  }
+
+  int arrivals;
+  int departures;
+
+protected:
+  virtual void on_arrival(const uint8_t* rom)
+  {
+    (void) rom;
+    arrivals += 1;
+  }
+
+  virtual void on_departure(const uint8_t* rom)
+  {
+    (void) rom;
+    departures += 1;
+  }
+};
+
+Bus bus;
+int status = 0;
+
+/**
+ * Run one monitor round and check reported changes and number of
+ * search passes (resets).
+ */
+void round(const char* name, Counter& monitor,
+	   int arrivals, int departures, uint32_t passes)
+{
+  monitor.arrivals = 0;
+  monitor.departures = 0;
+  uint32_t resets = bus.emulator.resets;
+  do {
+    if (monitor.poll() < 0) break;
+  } while (!monitor.done());
+  resets = bus.emulator.resets - resets;
+  bool ok = (monitor.arrivals == arrivals)
+    && (monitor.departures == departures)
+    && (resets == passes + 1);
+  printf("%s:arrivals=%d,departures=%d,passes=%u,count=%u,overflow=%d,%s\n",
+	 name, monitor.arrivals, monitor.departures, resets - 1,
+	 monitor.count(), monitor.overflow(), ok ? "passed" : "failed");
+  if (!ok) status = 1;
+}
+
+int main()
+{
+  uint8_t table[8][OWI::ROM_MAX];
+  Counter monitor(bus, table, 8);
+
+  // Arrivals, unchanged bus, departure and arrival, and empty bus
+  bus.emulator.add(0x28, 0x010203);
+  bus.emulator.add(0x28, 0x040506);
+  bus.emulator.add(0x10, 0x0a0b0c);
+  bus.emulator.add(0x01, 0x112233);
+  round("arrival", monitor, 4, 0, 4);
+  round("unchanged", monitor, 0, 0, 4);
+  bus.emulator.remove(1);
+  round("departure", monitor, 0, 1, 3);
+  bus.emulator.add(0x28, 0x778899);
+  round("change", monitor, 1, 0, 4);
+  bus.failure = true;
+  monitor.departures = 0;
+  bool ok = (monitor.poll() == OWI::ERROR) && (monitor.departures == 0)
+    && (monitor.count() == 4);
+  bus.failure = false;
+  printf("failure:departures=%d,%s\n", monitor.departures,
+	 ok ? "passed" : "failed");
+  if (!ok) status = 1;
+  while (bus.emulator.devices() != 0) bus.emulator.remove(0);
+  monitor.arrivals = 0;
+  monitor.departures = 0;
+  monitor.poll();
+  ok = (monitor.departures == 4) && (monitor.count() == 0);
+  printf("empty:departures=%d,%s\n", monitor.departures,
+	 ok ? "passed" : "failed");
+  if (!ok) status = 1;
+
+  // Table overflow; reported once, not as arrivals each round
+  uint8_t small[2][OWI::ROM_MAX];
+  Counter full(bus, small, 2);
+  bus.emulator.add(0x28, 0x010203);
+  bus.emulator.add(0x28, 0x040506);
+  bus.emulator.add(0x10, 0x0a0b0c);
+  round("overflow", full, 2, 0, 3);
+  round("overflow", full, 0, 0, 3);
+  if (!full.overflow()) status = 1;
+  for (uint8_t i = 0; i < bus.emulator.devices(); i++) {
+    if (!memcmp(bus.emulator.device(i).rom, full.rom(0), OWI::ROM_MAX)) {
+      bus.emulator.remove(i);
+      break;
+    }
+  }
+  round("room", full, 1, 1, 2);
+  if (full.overflow()) status = 1;
+
+  // Search statistics; rejected rom code and no device answering
+  while (bus.emulator.devices() != 0) bus.emulator.remove(0);
+  bus.emulator.add(0x28, 0x010203);
+  bus.emulator.device(0).rom[7] ^= 1;
+  uint8_t rom[OWI::ROM_MAX] = { 0 };
+  bus.search_stats_clear();
+  ok = (bus.search_rom(0, rom, OWI::FIRST) == OWI::ERROR);
+  const OWI::search_stats_t& stats = bus.search_stats();
+  ok = ok && (stats.errors == 3) && (stats.empty == 0)
+    && (stats.failures == 1);
+  bus.emulator.remove(0);
+  bus.presence = true;
+  bus.search_stats_clear();
+  ok = ok && (bus.search_rom(0, rom, OWI::FIRST) == OWI::ERROR);
+  ok = ok && (stats.errors == 0) && (stats.empty == 3)
+    && (stats.failures == 1);
+  bus.presence = false;
+  printf("stats:%s\n", ok ? "passed" : "failed");
+  if (!ok) status = 1;
+
+  printf("monitor:%s\n", status ? "failed" : "passed");
+  return (status);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file Multi.cpp
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * @section Description
+ * Co-simulation of the multi-identity slave (examples/Slave/Multi)
+ * with a software master. The master broadcasts write scratchpad
+ * (skip rom) with new alarm thresholds and configuration, and reads
+ * the scratchpad of each identity. Fails if an identity did not get
+ * the broadcast parameters.
+ * Usage: Multi [rounds]
+ */
+
+#include "GPIO.h"
+#include "OWI.h"
+#include "Software/OWI.h"
+#include "Slave/OWI.h"
+#include "Slave/Multi.h"
+#include "assert.h"
+
+namespace slave {
+#include "../../examples/Slave/Multi/Multi.ino"
+};
+
+namespace master {
+Software::OWI<BOARD::D7> owi;
+int rounds = 4;
+
+void setup()
+{
+  delay(10);
+}
+
+void loop()
+{
+  static int round = 0;
+  uint8_t config[3] = { (uint8_t) (40 + round), (uint8_t) (10 + round), 0x1f };
+  ASSERT(owi.reset());
+  owi.write(OWI::SKIP_ROM);
+  owi.write(slave::WRITE_SCRATCHPAD, config, sizeof(config));
+  for (uint8_t ix = 0; ix < slave::SENSORS; ix++) {
+    uint8_t sp[sizeof(slave::scratchpad_t)];
+    ASSERT(owi.match_rom(slave::identity[ix].rom));
+    owi.write(slave::READ_SCRATCHPAD);
+    owi.read(sp, sizeof(sp));
+    ASSERT(!memcmp(&sp[2], config, sizeof(config)));
+  }
+  printf("multi:round=%d,sensors=%d\n", round, slave::SENSORS);
+  if (++round == rounds) Sim::kernel().stop(0);
+  delay(1);
+}
+};
+
+int main(int argc, char* argv[])
+{
+  Sim::Kernel& sim = Sim::kernel();
+  if (argc > 1) master::rounds = atoi(argv[1]);
+  sim.wire(BOARD::D7);
+  sim.node("master", master::setup, master::loop);
+  sim.node("slave", slave::setup, slave::loop);
+  sim.run(1000000);
+}
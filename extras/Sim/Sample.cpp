@@ -0,0 +1,119 @@
+/**
+ * @file Sample.cpp
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * @section Description
+ * Host test of the binary sample stream encoder and decoder. Verifies
+ * decoding of dictionary and sample frames, that a valid frame found
+ * while synchronizing after a check sum error is reported, and that
+ * a sample frame with more than DELTA_MAX delta bytes is rejected.
+ * Fails on wrong results.
+ */
+
+#include "Arduino.h"
+#include "Sample/Encoder.h"
+#include "Sample/Decoder.h"
+
+/**
+ * Byte buffer output stream.
+ */
+class Buffer : public Print {
+public:
+  Buffer() : count(0) {}
+
+  virtual size_t write(uint8_t c)
+  {
+    if (count == sizeof(buf)) return (0);
+    buf[count++] = c;
+    return (1);
+  }
+
+  using Print::write;
+
+  uint8_t buf[256];
+  size_t count;
+};
+
+int status = 0;
+
+void check(const char* name, bool ok)
+{
+  printf("%s:%s\n", name, ok ? "passed" : "failed");
+  if (!ok) status = 1;
+}
+
+int main()
+{
+  const uint8_t rom[Sample::ROM_MAX] = { 0x28, 1, 2, 3, 4, 5, 6, 0x7f };
+
+  // Dictionary and samples; time stamps from the deltas
+  Buffer out;
+  Sample::Encoder encoder(out);
+  encoder.rom(3, rom);
+  encoder.sample(3, 0x0550, 1000);
+  encoder.sample(3, -0x0110, 1000 + 200000);
+  Sample::Decoder decoder;
+  int types[4];
+  int n = 0;
+  for (size_t i = 0; i < out.count; i++) {
+    int type = decoder.put(out.buf[i]);
+    if (type != 0 && n < 4) types[n++] = type;
+  }
+  check("stream", n == 3
+	&& types[0] == Sample::DICTIONARY
+	&& types[1] == Sample::SAMPLE
+	&& types[2] == Sample::SAMPLE
+	&& decoder.index() == 3
+	&& decoder.value() == -0x0110
+	&& decoder.timestamp() == 201000
+	&& decoder.rom(3) != NULL
+	&& !memcmp(decoder.rom(3), rom, sizeof(rom))
+	&& decoder.errors() == 0);
+
+  // Truncated dictionary frame followed by sample frames; the first
+  // sample is found in the buffered bytes after the check sum error
+  Buffer bad;
+  Sample::Encoder frames(bad);
+  frames.rom(3, rom);
+  bad.count = 2;
+  frames.sample(3, 0x0123, 42);
+  frames.sample(3, 0x0456, 50);
+  Sample::Decoder resync;
+  int samples = 0;
+  for (size_t i = 0; i < bad.count; i++)
+    if (resync.put(bad.buf[i]) == Sample::SAMPLE) samples += 1;
+  check("resync", samples == 2
+	&& resync.value() == 0x0456
+	&& resync.timestamp() == 50
+	&& resync.errors() != 0);
+
+  // Sample frame with six delta bytes is rejected
+  uint8_t frame[] = {
+    Sample::SAMPLE, 0, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x11, 0x22, 0
+  };
+  uint8_t crc = 0;
+  for (size_t i = 0; i < sizeof(frame) - 1; i++)
+    crc = Sample::crc_update(crc, frame[i]);
+  frame[sizeof(frame) - 1] = crc;
+  Sample::Decoder delta;
+  samples = 0;
+  for (size_t i = 0; i < sizeof(frame); i++)
+    if (delta.put(frame[i]) == Sample::SAMPLE) samples += 1;
+  check("delta", samples == 0 && delta.errors() != 0);
+
+  printf("sample:%s\n", status ? "failed" : "passed");
+  return (status);
+}
@@ -0,0 +1,273 @@
+/**
+ * @file Shared.cpp
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * @section Description
+ * Host thread test of the shared bus manager (Shared::OWI). Tasks
+ * are std::threads on a simulated bus that records the owner of
+ * each transaction, from reset, and counts bus access by other
+ * threads (interleaving). Measures lock overhead, waiting time and
+ * fairness under contention, and the transaction queue with a bus
+ * thread. Fails on interleaving with ownership, lost transactions or
+ * unfair service of tasks with the same priority.
+ * Usage: Shared [milli-seconds]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "GPIO.h"
+#include "OWI.h"
+#include "Shared/OWI.h"
+
+/**
+ * Simulated bus; always presence, reads ones. Yields on each access
+ * to provoke task switches within transactions.
+ */
+class Bus : public OWI {
+public:
+  Bus() : interleaved(0), m_owner(-1) {}
+
+  virtual bool reset()
+  {
+    m_owner = id();
+    std::this_thread::yield();
+    return (true);
+  }
+
+  virtual uint8_t read(uint8_t bits = CHARBITS)
+  {
+    check();
+    return ((1 << bits) - 1);
+  }
+
+  virtual void write(uint8_t value, uint8_t bits = CHARBITS)
+  {
+    (void) value;
+    (void) bits;
+    check();
+  }
+
+  using OWI::read;
+  using OWI::write;
+
+  /** Calling thread identity. */
+  static int& id()
+  {
+    static thread_local int id = -1;
+    return (id);
+  }
+
+  /** Number of bus access by other thread than transaction owner. */
+  std::atomic<uint32_t> interleaved;
+
+protected:
+  std::atomic<int> m_owner;
+
+  void check()
+  {
+    if (m_owner != id()) interleaved++;
+    std::this_thread::yield();
+  }
+};
+
+Bus bus;
+Shared::OWI owi(bus);
+std::atomic<bool> running;
+uint8_t rom[OWI::ROM_MAX] = { 0x28, 1, 2, 3, 4, 5, 6, 0 };
+
+/** Task statistics. */
+struct task_t {
+  int id;
+  uint8_t prio;
+  bool guard;
+  uint32_t count;
+  uint64_t wait;
+  uint64_t wait_max;
+};
+
+/** Transaction; match rom, write command and read scratchpad. */
+void transaction()
+{
+  uint8_t buf[9];
+  owi.match_rom(rom);
+  owi.write(0xbe);
+  owi.read(buf, sizeof(buf));
+}
+
+uint64_t ns()
+{
+  return (std::chrono::duration_cast<std::chrono::nanoseconds>
+	  (std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * Task; transactions until stopped. Tasks with priority above zero
+ * are periodic and sleep between transactions.
+ */
+void task(task_t* t)
+{
+  Bus::id() = t->id;
+  while (!running) std::this_thread::yield();
+  while (running) {
+    uint64_t start = ns();
+    if (t->guard) {
+      Shared::OWI::Guard guard(owi, t->prio);
+      uint64_t wait = ns() - start;
+      t->wait += wait;
+      if (wait > t->wait_max) t->wait_max = wait;
+      transaction();
+    }
+    else {
+      transaction();
+    }
+    t->count += 1;
+    if (t->prio != 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+}
+
+/**
+ * Run given tasks for given time and print statistics. Returns
+ * number of interleaved bus access.
+ */
+uint32_t run(const char* name, task_t* tasks, int n, int ms)
+{
+  std::thread* thread[8];
+  bus.interleaved = 0;
+  running = false;
+  for (int i = 0; i < n; i++) thread[i] = new std::thread(task, &tasks[i]);
+  running = true;
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  running = false;
+  for (int i = 0; i < n; i++) {
+    thread[i]->join();
+    delete thread[i];
+  }
+  for (int i = 0; i < n; i++) {
+    task_t& t = tasks[i];
+    printf("%s:task=%d,prio=%d,count=%u", name, t.id, t.prio, t.count);
+    if (t.guard && t.count != 0)
+      printf(",wait=%llu us,max=%llu us",
+	     (unsigned long long) t.wait / t.count / 1000,
+	     (unsigned long long) t.wait_max / 1000);
+    printf("\n");
+  }
+  uint32_t res = bus.interleaved;
+  printf("%s:interleaved=%u\n", name, res);
+  return (res);
+}
+
+int main(int argc, char* argv[])
+{
+  int ms = (argc > 1) ? atoi(argv[1]) : 500;
+  int status = 0;
+
+  // Lock overhead without contention; acquire and release
+  const uint32_t LOCKS = 1000000;
+  uint64_t start = ns();
+  for (uint32_t i = 0; i < LOCKS; i++) {
+    owi.acquire();
+    owi.release();
+  }
+  printf("overhead:acquire+release=%llu ns\n",
+	 (unsigned long long) (ns() - start) / LOCKS);
+
+  // Priority range, and non-waiting acquire while owned
+  if (owi.acquire(Shared::OWI::PRIO_MAX)) status = 1;
+  owi.acquire();
+  if (owi.try_acquire()) status = 1;
+  owi.release();
+
+  // Without ownership transactions are interleaved
+  task_t unguarded[] = {
+    { 0, 0, false, 0, 0, 0 },
+    { 1, 0, false, 0, 0, 0 },
+    { 2, 0, false, 0, 0, 0 }
+  };
+  if (run("unguarded", unguarded, 3, ms / 4) == 0) {
+    printf("unguarded:no interleaving; simulated bus check failed\n");
+    status = 1;
+  }
+
+  // With ownership; two back-to-back tasks with the same priority
+  // and two periodic tasks with higher priority
+  task_t guarded[] = {
+    { 0, 0, true, 0, 0, 0 },
+    { 1, 0, true, 0, 0, 0 },
+    { 2, 1, true, 0, 0, 0 },
+    { 3, 3, true, 0, 0, 0 }
+  };
+  if (run("guarded", guarded, 4, ms) != 0) status = 1;
+  uint32_t low = guarded[0].count;
+  uint32_t high = guarded[1].count;
+  if (low > high) std::swap(low, high);
+  printf("guarded:fairness=%u%%\n", high ? (100 * low) / high : 0);
+  if (low == 0 || (100 * low) / high < 80) status = 1;
+
+  // Transaction queue; producer threads post, a bus thread drains in
+  // batches while a task uses ownership
+  const int PRODUCERS = 3;
+  const int POSTS = 1000;
+  static Shared::OWI::transaction_t tx[PRODUCERS][POSTS];
+  static uint8_t buf[PRODUCERS][POSTS][9];
+  static Shared::OWI::segment_t seg[PRODUCERS][POSTS];
+  std::thread* thread[PRODUCERS];
+  std::atomic<int> posted(0);
+  bus.interleaved = 0;
+  running = true;
+  for (int i = 0; i < PRODUCERS; i++) {
+    thread[i] = new std::thread([i, &posted] {
+	Bus::id() = 100 + i;
+	for (int j = 0; j < POSTS; j++) {
+	  seg[i][j].op = Shared::OWI::TX_READ;
+	  seg[i][j].count = sizeof(buf[i][j]);
+	  seg[i][j].buf = buf[i][j];
+	  owi.post(tx[i][j], rom, &seg[i][j], 1);
+	  posted++;
+	}
+      });
+  }
+  task_t owner = { 4, 0, true, 0, 0, 0 };
+  std::thread user(task, &owner);
+  std::thread dispatcher([&posted] {
+      Bus::id() = 200;
+      uint32_t batches = 0;
+      uint32_t count = 0;
+      while (count < PRODUCERS * POSTS) {
+	uint8_t n = owi.dispatch(16);
+	if (n != 0) batches += 1;
+	count += n;
+	if (n == 0) std::this_thread::yield();
+      }
+      printf("queue:transactions=%u,batches=%u\n", count, batches);
+    });
+  for (int i = 0; i < PRODUCERS; i++) {
+    thread[i]->join();
+    delete thread[i];
+  }
+  dispatcher.join();
+  running = false;
+  user.join();
+  int done = 0;
+  for (int i = 0; i < PRODUCERS; i++)
+    for (int j = 0; j < POSTS; j++)
+      if (tx[i][j].status == Shared::OWI::TRANSACTION_DONE) done += 1;
+  printf("queue:done=%d,posted=%d,owner=%u,interleaved=%u\n",
+	 done, (int) posted, owner.count, (uint32_t) bus.interleaved);
+  if (done != PRODUCERS * POSTS || bus.interleaved != 0) status = 1;
+  printf("shared:%s\n", status ? "failed" : "passed");
+  return (status);
+}
@@ -0,0 +1,534 @@
+/**
+ * @file Sim.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * Host co-simulation kernel. Sketches (nodes), e.g. one master and
+ * several slaves, run setup() and loop() on their own thread with a
+ * local virtual clock. The nodes are connected by virtual open drain
+ * wires; one per board pin, low if any node drives the pin low.
+ *
+ * Pins that are not declared as wires are local to each node, e.g.
+ * a led pin.
+ *
+ * Only one node runs at a time. The running node continues until
+ * its clock passes the clock of another node that may change a wire,
+ * and the node with the earliest clock is then resumed. Wire levels
+ * are read from a change log at the clock of the reading node. A node
+ * that polls a pin without seeing a change, e.g. an idle slave, only
+ * holds back the other nodes at the next change of the pin; nodes
+ * must not drive a pin from such a polling loop without first seeing
+ * a change. Changes that should have been seen by reads already done are
+ * counted as violations.
+ *
+ * Virtual time advances with delay(), delayMicroseconds(), and a
+ * fixed cost for pin access and clock reads. Other code takes no
+ * time. The clock of each node may be scaled to model oscillator
+ * error. Threads that are not nodes (host mode) use the host clock.
+ */
+namespace Sim {
+/** Max number of nodes. */
+static const uint8_t NODE_MAX = 8;
+
+/** Number of wire pins. */
+static const uint8_t PIN_MAX = 32;
+
+/** Number of emulated analog inputs. */
+static const uint8_t ANALOG_MAX = 8;
+
+/** Size of emulated EEPROM. */
+static const uint16_t EEPROM_MAX = 1024;
+
+/**
+ * Virtual time cost (ns) of pin access (AVR at 16 MHz, polling loop
+ * of 4 cycles), clock read, and yield.
+ */
+static const uint32_t PIN_COST = 250;
+static const uint32_t CLOCK_COST = 1000;
+static const uint32_t YIELD_COST = 1000;
+
+/**
+ * Node; sketch functions, virtual clock, pin state, and board
+ * emulation (EEPROM, analog inputs and digital pins).
+ */
+struct node_t {
+  const char* name;		//!< Node name.
+  void (*setup)();		//!< Sketch setup function.
+  void (*loop)();		//!< Sketch loop function.
+  uint8_t id;			//!< Node index.
+  uint64_t time;		//!< Virtual clock (ns).
+  double scale;			//!< Clock scale (1.0 nominal).
+  int8_t pin;			//!< Latest action pin read, or -1.
+  bool level;			//!< Latest pin level read.
+  bool polling;			//!< Latest read without change.
+  uint64_t read;		//!< Latest pin read (ns).
+  uint32_t output;		//!< Pins in output mode.
+  uint32_t latch;		//!< Pin output latches.
+  uint32_t digital;		//!< Emulated digital pin values.
+  uint16_t analog[ANALOG_MAX];	//!< Emulated analog input values.
+  uint8_t eeprom[EEPROM_MAX];	//!< Emulated EEPROM.
+  std::condition_variable cv;	//!< Resume signal.
+};
+
+/**
+ * Simulation statistics.
+ */
+struct stats_t {
+  uint32_t switches;		//!< Number of node switches.
+  uint32_t changes;		//!< Number of wire changes.
+  uint32_t contentions;		//!< Pin driven both high and low.
+  uint32_t violations;		//!< Changes after reads at later time.
+};
+
+/**
+ * Wire change; virtual time and new level.
+ */
+struct change_t {
+  uint64_t time;		//!< Change time (ns).
+  bool level;			//!< New level.
+};
+
+/**
+ * Co-simulation kernel; nodes, wires and scheduling.
+ */
+class Kernel {
+public:
+  Kernel() :
+    m_nodes(0),
+    m_current(NULL),
+    m_wires(0),
+    m_status(0)
+  {
+    memset(&m_stats, 0, sizeof(m_stats));
+    for (uint8_t pin = 0; pin < PIN_MAX; pin++) {
+      m_low[pin] = 0;
+      m_high[pin] = 0;
+      m_base[pin] = true;
+      m_read[pin] = 0;
+    }
+    m_end.name = "end";
+    m_end.time = UINT64_MAX;
+  }
+
+  /**
+   * Add node with given name and sketch functions. Returns node for
+   * configuration, e.g. clock scale and analog inputs.
+   * @param[in] name of node.
+   * @param[in] setup sketch function.
+   * @param[in] loop sketch function.
+   * @return node.
+   */
+  node_t& node(const char* name, void (*setup)(), void (*loop)())
+  {
+    if (m_nodes == NODE_MAX) fail(name, "too many nodes");
+    node_t* n = new node_t();
+    n->name = name;
+    n->setup = setup;
+    n->loop = loop;
+    n->id = m_nodes;
+    n->time = 0;
+    n->scale = 1.0;
+    n->pin = -1;
+    n->level = true;
+    n->polling = false;
+    n->read = 0;
+    n->output = 0;
+    n->latch = 0;
+    n->digital = 0;
+    for (uint8_t i = 0; i < ANALOG_MAX; i++) n->analog[i] = 512;
+    memset(n->eeprom, 0xff, sizeof(n->eeprom));
+    m_node[m_nodes++] = n;
+    return (*n);
+  }
+
+  /**
+   * Declare given pin as a wire shared by all nodes.
+   * @param[in] pin number.
+   */
+  void wire(uint8_t pin)
+  {
+    m_wires |= (1UL << pin);
+  }
+
+  /**
+   * Run the nodes until given virtual time (us), or stop(). Does not
+   * return; exits the process with status.
+   * @param[in] us virtual time limit.
+   */
+  void run(uint64_t us)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_end.time = us * 1000;
+    for (uint8_t i = 0; i < m_nodes; i++)
+      std::thread(body, this, m_node[i]).detach();
+    m_current = (m_nodes != 0) ? m_node[0] : &m_end;
+    if (m_current != &m_end) m_current->cv.notify_one();
+    m_end.cv.wait(lock, [this] { return (m_current == &m_end); });
+    report();
+    fflush(stdout);
+    _exit(m_status);
+  }
+
+  /**
+   * Stop the simulation with given exit status. Called by a node.
+   * @param[in] status exit status.
+   */
+  void stop(int status)
+  {
+    node_t* n = self();
+    if (status != 0) m_status = status;
+    if (n == NULL) {
+      fflush(stdout);
+      _exit(m_status);
+    }
+    m_end.time = n->time;
+    resume(&m_end);
+    _exit(m_status);
+  }
+
+  /**
+   * Report failure for current node and stop with exit status 1.
+   * @param[in] file name.
+   * @param[in] msg message.
+   * @param[in] line number (default 0).
+   */
+  void fail(const char* file, const char* msg, int line = 0)
+  {
+    node_t* n = self();
+    fflush(stdout);
+    fprintf(stderr, "%s:%s:%d:%s\n", n ? n->name : "host", file, line, msg);
+    stop(1);
+  }
+
+  /**
+   * Return current node, or NULL for host threads.
+   * @return node.
+   */
+  static node_t*& self()
+  {
+    static thread_local node_t* node = NULL;
+    return (node);
+  }
+
+  /**
+   * Return local clock (ns) of current node; the virtual time divided
+   * by the clock scale. Host threads use the host monotonic clock.
+   * @return nano-seconds.
+   */
+  uint64_t time()
+  {
+    node_t* n = self();
+    if (n == NULL) {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return (ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+    }
+    tick(CLOCK_COST);
+    if (n->scale == 1.0) return (n->time);
+    return ((uint64_t) (n->time / n->scale));
+  }
+
+  /**
+   * Advance virtual time of current node by given nominal delay (ns),
+   * or sleep for host threads.
+   * @param[in] ns nano-seconds.
+   */
+  void delay(uint64_t ns)
+  {
+    if (self() == NULL) {
+      struct timespec ts = { (time_t) (ns / 1000000000), (long) (ns % 1000000000) };
+      nanosleep(&ts, NULL);
+      return;
+    }
+    tick(ns);
+  }
+
+  /**
+   * Read wire level of given pin at current node time.
+   * @param[in] pin number.
+   * @return level.
+   */
+  bool read(uint8_t pin)
+  {
+    node_t* n = self();
+    uint32_t mask = 1UL << pin;
+    if (n == NULL) return (level(pin, UINT64_MAX));
+    if ((m_wires & mask) == 0) {
+      tick(PIN_COST);
+      return (((n->output & mask) == 0) || ((n->latch & mask) != 0));
+    }
+    bool value = level(pin, n->time);
+    n->polling = (n->pin == pin) && (n->level == value);
+    n->pin = pin;
+    n->level = value;
+    n->read = n->time;
+    if (n->time > m_read[pin]) m_read[pin] = n->time;
+    advance(PIN_COST);
+    return (value);
+  }
+
+  /**
+   * Set pin mode and output latch of current node. A wire is low if
+   * any node drives the pin low.
+   * @param[in] pin number.
+   * @param[in] output mode.
+   * @param[in] latch output value.
+   */
+  void write(uint8_t pin, bool output, bool latch)
+  {
+    node_t* n = self();
+    if (n == NULL) return;
+    uint32_t mask = 1UL << pin;
+    uint16_t id = 1 << n->id;
+    n->output = output ? (n->output | mask) : (n->output & ~mask);
+    n->latch = latch ? (n->latch | mask) : (n->latch & ~mask);
+    if ((m_wires & mask) == 0) {
+      tick(PIN_COST);
+      return;
+    }
+    m_low[pin] = (output && !latch) ? (m_low[pin] | id) : (m_low[pin] & ~id);
+    m_high[pin] = (output && latch) ? (m_high[pin] | id) : (m_high[pin] & ~id);
+    bool value = (m_low[pin] == 0);
+    if (value != level(pin, n->time)) {
+      if (m_read[pin] > n->time) m_stats.violations += 1;
+      if (m_low[pin] != 0 && m_high[pin] != 0) m_stats.contentions += 1;
+      change_t change = { n->time, value };
+      std::deque<change_t>& log = m_log[pin];
+      std::deque<change_t>::iterator i = log.end();
+      while (i != log.begin() && (i - 1)->time > n->time) i--;
+      log.insert(i, change);
+      m_stats.changes += 1;
+      prune(pin);
+    }
+    tick(PIN_COST);
+  }
+
+  /**
+   * Return pin mode and output latch of current node.
+   * @param[in] pin number.
+   * @param[out] output mode.
+   * @param[out] latch output value.
+   */
+  void mode(uint8_t pin, bool& output, bool& latch)
+  {
+    node_t* n = self();
+    output = (n != NULL) && (n->output & (1UL << pin));
+    latch = (n != NULL) && (n->latch & (1UL << pin));
+  }
+
+  /**
+   * Return board emulation node; current node, or a shared node for
+   * host threads and static initialization.
+   * @return node.
+   */
+  node_t& board()
+  {
+    static node_t host;
+    node_t* n = self();
+    return (n != NULL ? *n : host);
+  }
+
+  /**
+   * Return simulation statistics.
+   * @return statistics.
+   */
+  const stats_t& stats() const
+  {
+    return (m_stats);
+  }
+
+protected:
+  /** Nodes. */
+  node_t* m_node[NODE_MAX];
+  uint8_t m_nodes;
+
+  /** End of simulation; pseudo node for the main thread. */
+  node_t m_end;
+
+  /** Node holding the baton. */
+  node_t* m_current;
+  std::mutex m_mutex;
+
+  /** Wire pins (bit per pin). */
+  uint32_t m_wires;
+
+  /** Nodes driving pins low and high (bit per node). */
+  uint16_t m_low[PIN_MAX];
+  uint16_t m_high[PIN_MAX];
+
+  /** Wire change logs; level before first change, and latest read. */
+  std::deque<change_t> m_log[PIN_MAX];
+  bool m_base[PIN_MAX];
+  uint64_t m_read[PIN_MAX];
+
+  /** Statistics and exit status. */
+  stats_t m_stats;
+  int m_status;
+
+  /**
+   * Node thread; wait for the baton, then run the sketch.
+   * @param[in] kernel simulation.
+   * @param[in] n node.
+   */
+  static void body(Kernel* kernel, node_t* n)
+  {
+    self() = n;
+    {
+      std::unique_lock<std::mutex> lock(kernel->m_mutex);
+      n->cv.wait(lock, [kernel, n] { return (kernel->m_current == n); });
+    }
+    n->setup();
+    while (1) n->loop();
+  }
+
+  /**
+   * Return wire level of given pin at given time.
+   * @param[in] pin number.
+   * @param[in] time nano-seconds.
+   * @return level.
+   */
+  bool level(uint8_t pin, uint64_t time)
+  {
+    std::deque<change_t>& log = m_log[pin];
+    for (size_t i = log.size(); i != 0; i--)
+      if (log[i - 1].time <= time) return (log[i - 1].level);
+    return (m_base[pin]);
+  }
+
+  /**
+   * Remove changes of given pin that are older than all node clocks.
+   * @param[in] pin number.
+   */
+  void prune(uint8_t pin)
+  {
+    uint64_t oldest = UINT64_MAX;
+    for (uint8_t i = 0; i < m_nodes; i++)
+      if (m_node[i]->time < oldest) oldest = m_node[i]->time;
+    std::deque<change_t>& log = m_log[pin];
+    while (log.size() > 1 && log[1].time <= oldest) {
+      m_base[pin] = log.front().level;
+      log.pop_front();
+    }
+  }
+
+  /**
+   * Return virtual time until which the given node will not change a
+   * wire; the node clock, or if the node polls a pin without change,
+   * the next change of the pin after the latest read.
+   * @param[in] n node.
+   * @return nano-seconds.
+   */
+  uint64_t horizon(const node_t* n) const
+  {
+    if (!n->polling) return (n->time);
+    const std::deque<change_t>& log = m_log[n->pin];
+    for (size_t i = 0; i < log.size(); i++)
+      if (log[i].time >= n->read) return (log[i].time);
+    return (UINT64_MAX);
+  }
+
+  /**
+   * Advance virtual time of current node by given nominal delay (ns)
+   * after an action other than pin read.
+   * @param[in] ns nano-seconds.
+   */
+  void tick(uint64_t ns)
+  {
+    node_t* n = self();
+    n->pin = -1;
+    n->polling = false;
+    advance(ns);
+  }
+
+  /**
+   * Advance virtual time of current node by given nominal delay (ns).
+   * Switch to the node with the earliest clock when the clock of the
+   * current node passes another node that may change a wire.
+   * @param[in] ns nano-seconds.
+   */
+  void advance(uint64_t ns)
+  {
+    node_t* n = self();
+    n->time += (n->scale == 1.0) ? ns : (uint64_t) (ns * n->scale + 0.5);
+    uint64_t bound = m_end.time;
+    for (uint8_t i = 0; i < m_nodes; i++) {
+      node_t* m = m_node[i];
+      if (m == n) continue;
+      uint64_t time = horizon(m);
+      if (time < bound) bound = time;
+    }
+    if (n->time <= bound) return;
+    node_t* next = &m_end;
+    for (uint8_t i = 0; i < m_nodes; i++) {
+      node_t* m = m_node[i];
+      if (m != n && m->time < next->time) next = m;
+    }
+    resume(next);
+  }
+
+  /**
+   * Pass the baton to given node and wait for it to return.
+   * @param[in] next node to resume.
+   */
+  void resume(node_t* next)
+  {
+    node_t* n = self();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stats.switches += 1;
+    m_current = next;
+    next->cv.notify_one();
+    n->cv.wait(lock, [this, n] { return (m_current == n); });
+  }
+
+  /**
+   * Print node clocks and statistics.
+   */
+  void report()
+  {
+    fflush(stdout);
+    fprintf(stderr, "sim:time=%llu us", (unsigned long long) m_end.time / 1000);
+    fprintf(stderr, ",switches=%u,changes=%u,contentions=%u,violations=%u\n",
+	    m_stats.switches, m_stats.changes,
+	    m_stats.contentions, m_stats.violations);
+    if (m_stats.violations != 0 && m_status == 0) m_status = 2;
+  }
+};
+
+/**
+ * Return the simulation kernel.
+ * @return kernel.
+ */
+inline Kernel& kernel()
+{
+  static Kernel sim;
+  return (sim);
+}
+};
+#endif
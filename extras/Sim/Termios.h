@@ -0,0 +1,248 @@
+/**
+ * @file Termios.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SIM_TERMIOS_H
+#define SIM_TERMIOS_H
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <deque>
+#include <mutex>
+#include "Arduino.h"
+
+/**
+ * Host serial port on a pseudo terminal. The sketch side (slave) is
+ * a raw terminal configured with termios by begin(). The line side
+ * (master) is used by an adapter emulator thread; recv() returns
+ * the bytes written by the sketch together with the line speed of
+ * the terminal when each byte was written, and send() returns bytes
+ * to the sketch.
+ */
+class Termios : public HardwareSerial {
+public:
+  Termios() :
+    in_flight(0),
+    m_master(-1),
+    m_slave(-1),
+    m_peek(-1),
+    m_busy(false)
+  {
+  }
+
+  ~Termios()
+  {
+    close();
+  }
+
+  /**
+   * Open pseudo terminal pair. Returns true(1) if successful
+   * otherwise false(0).
+   * @return bool.
+   */
+  bool open()
+  {
+    m_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (m_master < 0) return (false);
+    if (grantpt(m_master) < 0 || unlockpt(m_master) < 0) return (false);
+    m_slave = ::open(ptsname(m_master), O_RDWR | O_NOCTTY);
+    if (m_slave < 0) return (false);
+    struct termios tio;
+    if (tcgetattr(m_slave, &tio) < 0) return (false);
+    cfmakeraw(&tio);
+    return (tcsetattr(m_slave, TCSANOW, &tio) == 0);
+  }
+
+  /**
+   * Close pseudo terminal pair.
+   */
+  void close()
+  {
+    if (m_slave >= 0) ::close(m_slave);
+    if (m_master >= 0) ::close(m_master);
+    m_slave = -1;
+    m_master = -1;
+  }
+
+  /**
+   * @override{HardwareSerial}
+   * Set line speed. Bytes already written keep their line speed.
+   * @param[in] baudrate bits per second.
+   */
+  virtual void begin(unsigned long baudrate)
+  {
+    struct termios tio;
+    tcgetattr(m_slave, &tio);
+    cfsetispeed(&tio, speed(baudrate));
+    cfsetospeed(&tio, speed(baudrate));
+    tcsetattr(m_slave, TCSANOW, &tio);
+  }
+
+  /**
+   * @override{HardwareSerial}
+   * Number of received bytes available. Yields the processor when
+   * none so that the line side thread runs when the sketch polls.
+   * @return bytes.
+   */
+  virtual int available()
+  {
+    int n = 0;
+    if (ioctl(m_slave, FIONREAD, &n) < 0) n = 0;
+    n += (m_peek >= 0);
+    if (n == 0) std::this_thread::yield();
+    return (n);
+  }
+
+  /**
+   * @override{HardwareSerial}
+   * Read received byte, or negative error code if none available.
+   * @return byte or negative error code.
+   */
+  virtual int read()
+  {
+    int res = peek();
+    m_peek = -1;
+    return (res);
+  }
+
+  /**
+   * @override{HardwareSerial}
+   * Peek at received byte, or negative error code if none available.
+   * @return byte or negative error code.
+   */
+  virtual int peek()
+  {
+    uint8_t c;
+    if (m_peek < 0 && available() && ::read(m_slave, &c, 1) == 1) m_peek = c;
+    return (m_peek);
+  }
+
+  /**
+   * @override{HardwareSerial}
+   * Wait until the written bytes have been received and handled by
+   * the line side, i.e. echoes of written bytes have been sent.
+   */
+  virtual void flush()
+  {
+    while (1) {
+      {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_line.empty() && !m_busy) break;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * @override{HardwareSerial}
+   * Write byte at the current line speed.
+   * @param[in] c byte to write.
+   * @return number of bytes written.
+   */
+  virtual size_t write(uint8_t c)
+  {
+    struct termios tio;
+    tcgetattr(m_slave, &tio);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_line.push_back(baudrate(cfgetospeed(&tio)));
+      if (m_line.size() > in_flight) in_flight = m_line.size();
+    }
+    return (::write(m_slave, &c, 1) == 1 ? 1 : 0);
+  }
+
+  using HardwareSerial::write;
+
+  /**
+   * Line side; receive byte written by the sketch and line speed.
+   * Waits at most given time. Returns byte or negative error code on
+   * timeout.
+   * @param[out] baudrate line speed.
+   * @param[in] ms timeout in milli-seconds.
+   * @return byte or negative error code.
+   */
+  int recv(uint32_t& baudrate, int ms)
+  {
+    struct pollfd fds = { m_master, POLLIN, 0 };
+    uint8_t c;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_busy = false;
+    }
+    if (poll(&fds, 1, ms) != 1 || ::read(m_master, &c, 1) != 1) return (-1);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    baudrate = m_line.front();
+    m_line.pop_front();
+    m_busy = true;
+    return (c);
+  }
+
+  /**
+   * Line side; send byte to the sketch.
+   * @param[in] c byte to send.
+   */
+  void send(uint8_t c)
+  {
+    if (::write(m_master, &c, 1) != 1) perror("send");
+  }
+
+  /** Max number of written bytes not yet received by line side. */
+  size_t in_flight;
+
+protected:
+  /** Pseudo terminal line (master) and sketch (slave) side. */
+  int m_master;
+  int m_slave;
+
+  /** Peeked byte or negative if none. */
+  int m_peek;
+
+  /**
+   * Line speed of written bytes not yet received by line side, and
+   * line side handling received byte (until next recv()).
+   */
+  std::mutex m_mutex;
+  std::deque<uint32_t> m_line;
+  bool m_busy;
+
+  static speed_t speed(unsigned long baudrate)
+  {
+    switch (baudrate) {
+    case 4800: return (B4800);
+    case 9600: return (B9600);
+    case 19200: return (B19200);
+    case 57600: return (B57600);
+    case 115200: return (B115200);
+    }
+    return (B0);
+  }
+
+  static uint32_t baudrate(speed_t speed)
+  {
+    switch (speed) {
+    case B4800: return (4800);
+    case B9600: return (9600);
+    case B19200: return (19200);
+    case B57600: return (57600);
+    case B115200: return (115200);
+    }
+    return (0);
+  }
+};
+#endif
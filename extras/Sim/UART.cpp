@@ -0,0 +1,278 @@
+/**
+ * @file UART.cpp
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * @section Description
+ * Host test of the UART bus manager (UART::OWI) on a pseudo terminal
+ * (Termios). A line thread emulates the open drain wire on RX/TX
+ * with emulated devices (Emulator); each byte is decoded to a reset
+ * pulse or one time slot from its bit pattern and line speed, and
+ * the echo is the wire level at the bit sample points. The timing of
+ * each byte is verified against the 1-Wire standard speed limits;
+ * reset low time, write zero and one low time, master sample point
+ * and slot time. Also verifies reset, search, transfer with check sum
+ * and bit transfers, and that a reset after a lost echo discards the
+ * echoes in flight and reports a lost reset echo as adapter failure.
+ * Fails on timing violations or wrong results.
+ * Usage: UART [iterations]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "GPIO.h"
+#include "OWI.h"
+#include "UART/OWI.h"
+#include "Termios.h"
+#include "Emulator.h"
+
+Termios serial;
+Sim::Emulator bus;
+UART::OWI owi(serial);
+std::atomic<bool> running;
+
+/** Lost echo; delay next echo past the echo timeout, or drop echoes. */
+enum { ON_TIME, LATE_ECHO, LOST_ECHO };
+std::atomic<int> lost(ON_TIME);
+
+/**
+ * 1-Wire standard speed timing (us); reset low, write one low and
+ * master sample, write zero low, slot and recovery, and typical
+ * device presence and read zero timing.
+ */
+const double RESET_LOW_MIN = 480;
+const double RESET_LOW_MAX = 960;
+const double LOW_ONE_MIN = 1;
+const double LOW_ONE_MAX = 15;
+const double SAMPLE_MAX = 15;
+const double LOW_ZERO_MIN = 60;
+const double LOW_ZERO_MAX = 120;
+const double SLOT_MIN = 61;
+const double PRESENCE_WAIT = 30;
+const double PRESENCE_LOW = 120;
+const double READ_ZERO_LOW = 30;
+
+/** Line statistics; bytes, reset and slot bytes, and violations. */
+uint32_t bytes = 0;
+uint32_t resets = 0;
+uint32_t slots = 0;
+uint32_t violations = 0;
+
+/**
+ * Check given time against limits; count violation and print first
+ * violations.
+ */
+void check(const char* name, double us, double min, double max)
+{
+  if (us >= min && us <= max) return;
+  if (violations++ < 8)
+    printf("violation:%s=%.1f us (%.0f..%.0f)\n", name, us, min, max);
+}
+
+/**
+ * Line emulation; decode byte to reset pulse or time slot. The byte
+ * (start bit and data bits LSB first) must be a single low pulse;
+ * the low time gives reset, write zero or write one (read) slot.
+ * The echo bits are sampled in the middle of each bit.
+ */
+void line()
+{
+  while (running) {
+    uint32_t baudrate;
+    int c = serial.recv(baudrate, 10);
+    if (c < 0) continue;
+    bytes += 1;
+    double bit = 1000000.0 / baudrate;
+    uint8_t zeros = 0;
+    while (zeros < 8 && ((c >> zeros) & 1) == 0) zeros++;
+    if (zeros < 8 && (c >> zeros) != (0xff >> zeros)) {
+      check("pulses", 2, 1, 1);
+      continue;
+    }
+    double low = (1 + zeros) * bit;
+    double release = low;
+    double from = 0, to = 0;
+    if (low >= RESET_LOW_MIN) {
+      resets += 1;
+      check("reset", low, RESET_LOW_MIN, RESET_LOW_MAX);
+      if (bus.reset()) {
+	from = release + PRESENCE_WAIT;
+	to = from + PRESENCE_LOW;
+      }
+    }
+    else {
+      slots += 1;
+      check("slot", 10 * bit, SLOT_MIN, LOW_ZERO_MAX);
+      if (zeros == 0) {
+	check("one", low, LOW_ONE_MIN, LOW_ONE_MAX);
+	check("sample", 1.5 * bit, low, SAMPLE_MAX);
+	if (!bus.slot(1)) to = READ_ZERO_LOW;
+      }
+      else {
+	check("zero", low, LOW_ZERO_MIN, LOW_ZERO_MAX);
+	bus.slot(0);
+      }
+    }
+    uint8_t echo = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+      double t = (1.5 + i) * bit;
+      if (t >= low && (t < from || t >= to)) echo |= (1 << i);
+    }
+    if (lost == LOST_ECHO) continue;
+    if (lost == LATE_ECHO) {
+      int ms = UART::OWI::ECHO_TIMEOUT * 4;
+      std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+      lost = ON_TIME;
+    }
+    serial.send(echo);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  int iterations = (argc > 1) ? atoi(argv[1]) : 100;
+  int status = 0;
+
+  if (!serial.open()) {
+    perror("pty");
+    return (1);
+  }
+  running = true;
+  std::thread thread(line);
+
+  // Empty bus
+  if (owi.reset()) status = 1;
+  owi.backoff_clear();
+
+  // Devices
+  bus.add(0x28, 0x010203);
+  bus.add(0x28, 0x040506);
+  bus.add(0x10, 0x0a0b0c);
+
+  // Search; all devices found once
+  int found = 0;
+  for (int i = 0; i < iterations; i++) {
+    uint8_t rom[OWI::ROM_MAX] = { 0 };
+    int8_t last = OWI::FIRST;
+    uint8_t n = 0;
+    do {
+      last = owi.search_rom(0, rom, last);
+      if (last == OWI::ERROR) break;
+      for (uint8_t j = 0; j < bus.devices(); j++)
+	if (!memcmp(rom, bus.device(j).rom, sizeof(rom))) n += 1;
+    } while (last != OWI::LAST);
+    if (n == bus.devices()) found += 1;
+  }
+  printf("search:found=%d/%d\n", found, iterations);
+  if (found != iterations) status = 1;
+
+  // Write and read scratchpad; pipelined transfer with check sum. A
+  // failed iteration is retried once as host scheduling may delay
+  // the line thread past the echo timeout
+  int passed = 0;
+  int retries = 0;
+  for (int i = 0; i < iterations; i++) {
+    for (int retry = 0; retry < 2; retry++) {
+      Sim::device_t& dev = bus.device(i % bus.devices());
+      uint8_t config[3] = { (uint8_t) i, (uint8_t) ~i, 0x1f };
+      uint8_t cmd = 0x4e;
+      OWI::segment_t wr[] = {
+	{ OWI::TX_WRITE, sizeof(cmd), &cmd },
+	{ OWI::TX_WRITE, sizeof(config), config }
+      };
+      uint8_t sp[8];
+      bool ok = owi.match_rom(dev.rom) && owi.transfer(wr, 2);
+      cmd = 0xbe;
+      OWI::segment_t rd[] = {
+	{ OWI::TX_WRITE, sizeof(cmd), &cmd },
+	{ OWI::TX_READ | OWI::TX_CRC8 | OWI::TX_RESTART, sizeof(sp), sp },
+	{ OWI::TX_CHECK | OWI::TX_CRC8, 0, NULL }
+      };
+      ok = ok && owi.match_rom(dev.rom) && owi.transfer(rd, 3);
+      if (ok && !memcmp(&sp[2], config, sizeof(config))) {
+	passed += 1;
+	break;
+      }
+      retries += 1;
+    }
+  }
+  printf("scratchpad:passed=%d/%d,retries=%d\n", passed, iterations,
+	 retries);
+  if (passed != iterations) status = 1;
+
+  // Read scratchpad with buffer read; pipelined with check sum
+  passed = 0;
+  retries = 0;
+  serial.in_flight = 0;
+  for (int i = 0; i < iterations; i++) {
+    for (int retry = 0; retry < 2; retry++) {
+      Sim::device_t& dev = bus.device(i % bus.devices());
+      uint8_t sp[9];
+      if (owi.match_rom(dev.rom)
+	  && (owi.write(0xbe), owi.read(sp, sizeof(sp)))
+	  && !memcmp(sp, dev.scratchpad, sizeof(sp))) {
+	passed += 1;
+	break;
+      }
+      retries += 1;
+    }
+  }
+  printf("read:passed=%d/%d,retries=%d,in_flight=%zu\n", passed,
+	 iterations, retries, serial.in_flight);
+  if (passed != iterations || serial.in_flight <= CHARBITS) status = 1;
+
+  // Bit transfers; read rom is the wired-and
+  uint8_t rom[OWI::ROM_MAX];
+  uint8_t expected[OWI::ROM_MAX];
+  memset(expected, 0xff, sizeof(expected));
+  for (uint8_t j = 0; j < bus.devices(); j++)
+    for (uint8_t i = 0; i < sizeof(rom); i++) expected[i] &= bus.device(j).rom[i];
+  bool ok = owi.reset();
+  owi.write(0x33 & 0x0f, 4);
+  owi.write(0x33 >> 4, 4);
+  for (uint8_t i = 0; i < sizeof(rom); i++) rom[i] = owi.read(3) | (owi.read(5) << 3);
+  ok = ok && !memcmp(rom, expected, sizeof(rom));
+  printf("bits:%s\n", ok ? "passed" : "failed");
+  if (!ok) status = 1;
+
+  // Lost echo with write zero slots in flight; reset discards the
+  // late echoes. Lost reset echo is an adapter failure
+  uint8_t zeros[4] = { 0 };
+  OWI::segment_t wr[] = {
+    { OWI::TX_WRITE, sizeof(zeros), zeros }
+  };
+  ok = owi.reset();
+  lost = LATE_ECHO;
+  ok = ok && !owi.transfer(wr, 1);
+  ok = ok && owi.reset() && owi.bus_state() == OWI::BUS_PRESENT;
+  lost = LOST_ECHO;
+  ok = ok && !owi.reset() && owi.bus_state() == OWI::BUS_ERROR;
+  lost = ON_TIME;
+  ok = ok && owi.reset() && owi.bus_state() == OWI::BUS_PRESENT;
+  printf("lost:%s\n", ok ? "passed" : "failed");
+  if (!ok) status = 1;
+
+  // One byte per time slot
+  running = false;
+  thread.join();
+  printf("line:bytes=%u,resets=%u,slots=%u,violations=%u\n",
+	 bytes, resets, slots, violations);
+  if (resets != bus.resets || slots != bus.slots || bytes != resets + slots)
+    status = 1;
+  if (violations != 0) status = 1;
+  printf("uart:%s\n", status ? "failed" : "passed");
+  return (status);
+}
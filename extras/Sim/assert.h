@@ -0,0 +1,33 @@
+/**
+ * @file assert.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SIM_ASSERT_H
+#define SIM_ASSERT_H
+
+#include "Sim.h"
+
+/**
+ * Host replacement of the sketch assert macro. A failed assertion
+ * stops the simulation with exit status 1.
+ * @param[in] expr expression that should be true.
+ */
+#define ASSERT(expr)							\
+  do {									\
+    if (!(expr)) Sim::kernel().fail(__FILE__, "ASSERT(" #expr ")", __LINE__); \
+  } while (0)
+#endif
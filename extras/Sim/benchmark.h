@@ -0,0 +1,62 @@
+/**
+ * @file benchmark.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SIM_BENCHMARK_H
+#define SIM_BENCHMARK_H
+
+#include "Arduino.h"
+
+/**
+ * Host replacement of the sketch benchmark macros. Measurements are
+ * in virtual micro-seconds of the calling node; the clock read cost
+ * is removed with the baseline.
+ */
+inline unsigned long& benchmark_baseline()
+{
+  static thread_local unsigned long baseline = 0;
+  return (baseline);
+}
+
+/**
+ * Measure the clock read overhead; subtracted from measurements.
+ * @param[in] n number of measurements.
+ */
+#define BENCHMARK_BASELINE(n)						\
+  do {									\
+    unsigned long start = micros();					\
+    for (int i = 0; i < (n); i++) micros();				\
+    benchmark_baseline() = (micros() - start) / ((n) + 1);		\
+  } while (0)
+
+/**
+ * Evaluate given expression and print line number, expression and
+ * micro-seconds.
+ * @param[in] expr expression to measure.
+ */
+#define MEASURE(expr)							\
+  do {									\
+    unsigned long start = micros();					\
+    expr;								\
+    unsigned long us = micros() - start - benchmark_baseline();	\
+    Serial.print(__LINE__);						\
+    Serial.print(':');							\
+    Serial.print(F(#expr));						\
+    Serial.print('=');							\
+    Serial.println(us);							\
+  } while (0)
+#endif
@@ -0,0 +1,367 @@
+/**
+ * @file Coupler/OWI.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef COUPLER_OWI_H
+#define COUPLER_OWI_H
+
+#include "OWI.h"
+#include "Driver/DS2409.h"
+
+/**
+ * One Wire Interface (OWI) Bus Manager class for networks branched
+ * with DS2409 MicroLAN Couplers on the trunk. The topology; couplers,
+ * and devices on the trunk and on each main and auxiliary branch, is
+ * discovered and cached in a given node table. Addressing a device
+ * with match_rom() switches to the device branch when needed; at most
+ * one branch is connected, and it stays connected while devices on
+ * the trunk are addressed. The node table is ordered by branch so
+ * that iteration with next() groups device access per branch, and
+ * each branch is switched once per iteration.
+ */
+namespace Coupler {
+class OWI : public ::OWI {
+public:
+  /** Trunk branch; always connected. */
+  static const uint8_t TRUNK = 0xff;
+
+  /**
+   * Topology node; device rom code and branch. The branch is the
+   * coupler node index and auxiliary flag (LSB), or TRUNK.
+   */
+  struct node_t {
+    uint8_t rom[ROM_MAX];	//!< Device rom code.
+    uint8_t branch;		//!< Device branch.
+  };
+
+  /**
+   * Construct coupler bus manager on given bus manager with given
+   * node table.
+   * @param[in] owi bus manager for trunk.
+   * @param[in] node table.
+   * @param[in] max number of nodes in table.
+   */
+  OWI(::OWI& owi, node_t* node, uint8_t max) :
+    m_owi(owi),
+    m_node(node),
+    m_max(max),
+    m_count(0),
+    m_branch(TRUNK),
+    m_switches(0),
+    m_resumable(false)
+  {
+    memset(m_resume, 0, sizeof(m_resume));
+  }
+
+  /**
+   * @override{OWI}
+   * Reset the one wire bus (trunk and connected branch) and check
+   * that at least one device is presence.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool reset()
+  {
+    bool res = m_owi.reset();
+    bus_state(m_owi.bus_state());
+    return (res);
+  }
+
+  /**
+   * @override{OWI}
+   * Read the given number of bits from the one wire bus.
+   * @param[in] bits to be read.
+   * @return value read.
+   */
+  virtual uint8_t read(uint8_t bits = CHARBITS)
+  {
+    return (m_owi.read(bits));
+  }
+
+  /**
+   * @override{OWI}
+   * Write the given value to the one wire bus.
+   * @param[in] value to write.
+   * @param[in] bits to be written.
+   */
+  virtual void write(uint8_t value, uint8_t bits = CHARBITS)
+  {
+    m_owi.write(value, bits);
+  }
+
+  using ::OWI::read;
+  using ::OWI::write;
+  using ::OWI::match_rom;
+
+  /**
+   * @override{OWI}
+   * Execute the given transaction.
+   * @param[in] seg transaction segments.
+   * @param[in] count number of segments.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool transfer(const segment_t* seg, uint8_t count)
+  {
+    return (m_owi.transfer(seg, count));
+  }
+
+  /**
+   * @override{OWI}
+   * Search support function.
+   * @param[in,out] dir bit to write when discrepancy read.
+   * @return 2-bits read and bit written.
+   */
+  virtual int8_t triplet(uint8_t& dir)
+  {
+    return (m_owi.triplet(dir));
+  }
+
+  /**
+   * @override{OWI}
+   * Match device rom. Switch to the device branch if the device is
+   * in the node table and the branch is not connected. Devices on
+   * the trunk, and unknown devices, are addressed without switching;
+   * the connected branch is kept.
+   * @param[in] code device identity.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool match_rom(uint8_t* code)
+  {
+    int16_t ix = find(code);
+    m_resumable = false;
+    if (ix >= 0 && m_node[ix].branch != TRUNK) {
+      if (!select(m_node[ix].branch)) return (false);
+    }
+    if (!m_owi.match_rom(code)) return (false);
+    memcpy(m_resume, code, sizeof(m_resume));
+    m_resumable = true;
+    return (true);
+  }
+
+  /**
+   * @override{OWI}
+   * Resume device access. The latest device addressed with
+   * match_rom() is resumed if no branch switch has been made since;
+   * the coupler commands address the coupler and the device no
+   * longer has the resume flag. Otherwise the device is matched
+   * again, with branch switch.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool resume()
+  {
+    if (m_resumable) return (m_owi.resume());
+    if (m_resume[0] == 0) return (false);
+    uint8_t code[ROM_MAX];
+    memcpy(code, m_resume, sizeof(code));
+    return (match_rom(code));
+  }
+
+  /**
+   * Discover topology; couplers on the trunk, devices on the trunk,
+   * and devices on each coupler main and auxiliary branch. Nested
+   * couplers are not supported. All branches are disconnected on
+   * return. Returns number of nodes or negative error code if the
+   * node table is full.
+   * @return number of nodes or negative error code.
+   */
+  int8_t discover()
+  {
+    uint8_t code[ROM_MAX];
+    int8_t last = FIRST;
+    m_count = 0;
+    m_branch = TRUNK;
+    m_resumable = false;
+    memset(m_resume, 0, sizeof(m_resume));
+
+    // Find couplers and disconnect branches
+    do {
+      last = m_owi.search_rom(DS2409::FAMILY_CODE, code, last);
+      if (last == ERROR) break;
+      if (!add(code, TRUNK)) return (ERROR);
+    } while (last != LAST);
+    uint8_t couplers = m_count;
+    for (uint8_t ix = 0; ix < couplers; ix++) {
+      DS2409 coupler(m_owi, m_node[ix].rom);
+      coupler.all_lines_off();
+    }
+
+    // Find devices on trunk and each branch
+    if (!scan(TRUNK)) return (ERROR);
+    for (uint8_t ix = 0; ix < couplers; ix++) {
+      for (uint8_t aux = 0; aux < 2; aux++) {
+	uint8_t branch = (ix << 1) | aux;
+	if (!select(branch)) continue;
+	if (!scan(branch)) return (ERROR);
+      }
+    }
+    select(TRUNK);
+    return (m_count);
+  }
+
+  /**
+   * Connect given branch, and disconnect current branch. Returns
+   * true(1) if successful otherwise false(0).
+   * @param[in] branch to connect, or TRUNK.
+   * @return bool.
+   */
+  bool select(uint8_t branch)
+  {
+    if (branch == m_branch) return (true);
+    m_resumable = false;
+    if (m_branch != TRUNK) {
+      DS2409 coupler(m_owi, m_node[m_branch >> 1].rom);
+      if (!coupler.all_lines_off()) return (false);
+      m_branch = TRUNK;
+    }
+    if (branch != TRUNK) {
+      DS2409 coupler(m_owi, m_node[branch >> 1].rom);
+      bool res;
+      if (branch & 0x01)
+	res = coupler.smart_on(true);
+      else
+	res = coupler.direct_on_main();
+      if (!res) return (false);
+      m_switches += 1;
+    }
+    m_branch = branch;
+    return (true);
+  }
+
+  /**
+   * Get number of nodes.
+   * @return count.
+   */
+  uint8_t count() const
+  {
+    return (m_count);
+  }
+
+  /**
+   * Get rom code for given node.
+   * @param[in] ix node index.
+   * @return rom code.
+   */
+  uint8_t* rom(uint8_t ix)
+  {
+    return (m_node[ix].rom);
+  }
+
+  /**
+   * Get branch for given node.
+   * @param[in] ix node index.
+   * @return branch.
+   */
+  uint8_t branch(uint8_t ix) const
+  {
+    return (m_node[ix].branch);
+  }
+
+  /**
+   * Get number of branch switches.
+   * @return count.
+   */
+  uint16_t switches() const
+  {
+    return (m_switches);
+  }
+
+  /**
+   * Find node with given rom code. Return node index or negative
+   * error code.
+   * @param[in] code device rom code.
+   * @return node index or negative error code.
+   */
+  int16_t find(const uint8_t* code) const
+  {
+    for (uint8_t ix = 0; ix < m_count; ix++)
+      if (!memcmp(m_node[ix].rom, code, ROM_MAX)) return (ix);
+    return (-1);
+  }
+
+  /**
+   * Get next node with given family code (zero for all) after given
+   * node index (negative to start). Nodes are ordered by branch.
+   * Return node index or negative error code when completed.
+   * @param[in] family code (default all).
+   * @param[in] ix node index (default start).
+   * @return node index or negative error code.
+   */
+  int16_t next(uint8_t family = 0, int16_t ix = -1) const
+  {
+    for (ix += 1; ix < m_count; ix++)
+      if (family == 0 || m_node[ix].rom[0] == family) return (ix);
+    return (-1);
+  }
+
+protected:
+  /** Bus manager for trunk. */
+  ::OWI& m_owi;
+
+  /** Node table. */
+  node_t* m_node;
+
+  /** Max number of nodes. */
+  uint8_t m_max;
+
+  /** Number of nodes. */
+  uint8_t m_count;
+
+  /** Connected branch. */
+  uint8_t m_branch;
+
+  /** Number of branch switches. */
+  uint16_t m_switches;
+
+  /** Latest matched device; resume flag valid if no branch switch. */
+  uint8_t m_resume[ROM_MAX];
+  bool m_resumable;
+
+  /**
+   * Add node with given rom code and branch. Returns false(0) if
+   * the table is full.
+   * @param[in] code device rom code.
+   * @param[in] branch device branch.
+   * @return bool.
+   */
+  bool add(const uint8_t* code, uint8_t branch)
+  {
+    if (m_count == m_max) return (false);
+    memcpy(m_node[m_count].rom, code, ROM_MAX);
+    m_node[m_count].branch = branch;
+    m_count += 1;
+    return (true);
+  }
+
+  /**
+   * Search connected branch and add devices not already in the node
+   * table with given branch. Returns false(0) if the table is full.
+   * @param[in] branch connected branch.
+   * @return bool.
+   */
+  bool scan(uint8_t branch)
+  {
+    uint8_t code[ROM_MAX];
+    int8_t last = FIRST;
+    do {
+      last = m_owi.search_rom(0, code, last);
+      if (last == ERROR) break;
+      if (find(code) < 0 && !add(code, branch)) return (false);
+    } while (last != LAST);
+    return (true);
+  }
+};
+};
+#endif
@@ -168,6 +168,65 @@ public:
     return (m_owi.read(6));
   }
 
+  /**
+   * Read given number of bytes from remote SRAM address to given
+   * buffer. Return number of bytes read if successful, otherwise
+   * negative error code.
+   * @param[in] dest buffer.
+   * @param[in] src remote SRAM address.
+   * @param[in] count number of bytes (1..255).
+   * @return number of bytes or negative error code.
+   */
+  int sram_read(void* dest, uint16_t src, uint8_t count)
+  {
+    return (memory_read(SRAM_READ, dest, src, count));
+  }
+
+  /**
+   * Write given number of bytes from buffer to remote SRAM address.
+   * Return number of bytes written if successful, otherwise negative
+   * error code.
+   * @param[in] dest remote SRAM address.
+   * @param[in] src buffer.
+   * @param[in] count number of bytes (1..255).
+   * @return number of bytes or negative error code.
+   */
+  int sram_write(uint16_t dest, const void* src, uint8_t count)
+  {
+    return (memory_write(SRAM_WRITE, dest, src, count));
+  }
+
+  /**
+   * Read given number of bytes from remote EEPROM address to given
+   * buffer. Return number of bytes read if successful, otherwise
+   * negative error code.
+   * @param[in] dest buffer.
+   * @param[in] src remote EEPROM address.
+   * @param[in] count number of bytes (1..255).
+   * @return number of bytes or negative error code.
+   */
+  int eeprom_read(void* dest, uint16_t src, uint8_t count)
+  {
+    return (memory_read(EEPROM_READ, dest, src, count));
+  }
+
+  /**
+   * Write given number of bytes from buffer to remote EEPROM address.
+   * Return number of bytes written if successful, otherwise negative
+   * error code.
+   * @param[in] dest remote EEPROM address.
+   * @param[in] src buffer.
+   * @param[in] count number of bytes (1..32).
+   * @return number of bytes or negative error code.
+   */
+  int eeprom_write(uint16_t dest, const void* src, uint8_t count)
+  {
+    int res = memory_write(EEPROM_WRITE, dest, src, count);
+    if (res < 0) return (res);
+    if (m_owi.read(2) != 0b10) return (-1);
+    return (res);
+  }
+
   /**
    * Read rom identity code for device. Return zero(0) if successful,
    * otherwise negative error code.
@@ -235,6 +294,57 @@ protected:
   /** Short address. */
   uint8_t m_label;
 
+  /**
+   * Issue given memory read command with remote address and count.
+   * Data is read directly to given buffer and the check sum is
+   * verified. Return number of bytes read if successful, otherwise
+   * negative error code.
+   * @param[in] cmd memory read command.
+   * @param[in] dest buffer.
+   * @param[in] src remote address.
+   * @param[in] count number of bytes.
+   * @return number of bytes or negative error code.
+   */
+  int memory_read(uint8_t cmd, void* dest, uint16_t src, uint8_t count)
+  {
+    if (count == 0) return (-1);
+    if (!MATCH()) return (-1);
+    OWI::segment_t tx[] = {
+      { OWI::TX_WRITE, 1, &cmd },
+      { OWI::TX_WRITE, sizeof(src), &src },
+      { OWI::TX_WRITE, 1, &count },
+      { OWI::TX_READ | OWI::TX_CRC8, count, dest },
+      { OWI::TX_CHECK | OWI::TX_CRC8, 0, NULL }
+    };
+    if (!m_owi.transfer(tx, sizeof(tx) / sizeof(tx[0]))) return (-1);
+    return (count);
+  }
+
+  /**
+   * Issue given memory write command with remote address, count, data
+   * from given buffer and check sum. Return number of bytes written
+   * if successful, otherwise negative error code.
+   * @param[in] cmd memory write command.
+   * @param[in] dest remote address.
+   * @param[in] src buffer.
+   * @param[in] count number of bytes.
+   * @return number of bytes or negative error code.
+   */
+  int memory_write(uint8_t cmd, uint16_t dest, const void* src, uint8_t count)
+  {
+    if (count == 0) return (-1);
+    if (!MATCH()) return (-1);
+    OWI::segment_t tx[] = {
+      { OWI::TX_WRITE, 1, &cmd },
+      { OWI::TX_WRITE, sizeof(dest), &dest },
+      { OWI::TX_WRITE, 1, &count },
+      { OWI::TX_WRITE | OWI::TX_CRC8, count, (void*) src },
+      { OWI::TX_APPEND | OWI::TX_CRC8, 0, NULL }
+    };
+    if (!m_owi.transfer(tx, sizeof(tx) / sizeof(tx[0]))) return (-1);
+    return (count);
+  }
+
   /** Return value for ANALOG_READ. */
   struct analog_read_res_t {
     uint16_t value;		//!< Analog value read.
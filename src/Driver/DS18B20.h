@@ -56,8 +56,10 @@ public:
   DS18B20(OWI& owi, uint8_t* rom = NULL) :
     OWI::Device(owi, rom),
     m_start(0),
-    m_converting(false)
+    m_converting(false),
+    m_shadow(0)
   {
+    memset(m_shadow_rom, 0, sizeof(m_shadow_rom));
     resolution(12);
     set_trigger(70, 75);
   }
@@ -96,6 +98,135 @@ public:
     return (m_scratchpad.temperature * 0.0625);
   }
 
+  /**
+   * Get the latest temperature reading in fixed point format (Q4,
+   * 1/16 degree) from the scratchpad copy. The undefined least
+   * significant bits for the conversion resolution are cleared.
+   * @return temperature (1/16 C).
+   */
+  int16_t temperature_raw() const
+  {
+    return (m_scratchpad.temperature & ~((1 << (12 - resolution())) - 1));
+  }
+
+  /**
+   * Get the latest temperature reading in centi-degrees (1/100 C)
+   * from the scratchpad copy. Integer only, Q4 times 6.25 rounded
+   * down.
+   * @return temperature (1/100 C).
+   */
+  int16_t temperature_centi() const
+  {
+    int16_t raw = temperature_raw();
+    return (raw * 6 + (raw >> 2));
+  }
+
+  /**
+   * Fixed point temperature aggregation over a small fixed ring of
+   * samples; running min, max and mean, and decimation. Samples are
+   * in Q4 format (1/16 C), see temperature_raw().
+   * @param[in] N number of samples in ring.
+   */
+  template<uint8_t N>
+  class Aggregate {
+  public:
+    /**
+     * Construct empty aggregation.
+     */
+    Aggregate() :
+      m_count(0),
+      m_next(0),
+      m_added(0),
+      m_sum(0)
+    {
+    }
+
+    /**
+     * Add given sample to the ring. Returns true(1) when N samples
+     * have been added since the previous decimation, the mean()
+     * is then the decimated value, otherwise false(0).
+     * @param[in] sample temperature (1/16 C).
+     * @return bool.
+     */
+    bool add(int16_t sample)
+    {
+      if (m_count == N)
+	m_sum -= m_sample[m_next];
+      else
+	m_count += 1;
+      m_sample[m_next] = sample;
+      m_sum += sample;
+      if (++m_next == N) m_next = 0;
+      if (++m_added < N) return (false);
+      m_added = 0;
+      return (true);
+    }
+
+    /**
+     * Return number of samples in ring.
+     * @return count.
+     */
+    uint8_t count() const
+    {
+      return (m_count);
+    }
+
+    /**
+     * Return lowest sample in ring, or zero if the ring is empty;
+     * check count() first. Not named min() as that is a macro in the
+     * Arduino core.
+     * @return temperature (1/16 C).
+     */
+    int16_t lowest() const
+    {
+      if (m_count == 0) return (0);
+      int16_t res = m_sample[0];
+      for (uint8_t i = 1; i < m_count; i++)
+	if (m_sample[i] < res) res = m_sample[i];
+      return (res);
+    }
+
+    /**
+     * Return highest sample in ring, or zero if the ring is empty;
+     * check count() first.
+     * @return temperature (1/16 C).
+     */
+    int16_t highest() const
+    {
+      if (m_count == 0) return (0);
+      int16_t res = m_sample[0];
+      for (uint8_t i = 1; i < m_count; i++)
+	if (m_sample[i] > res) res = m_sample[i];
+      return (res);
+    }
+
+    /**
+     * Return mean of samples in ring, or zero if the ring is empty.
+     * @return temperature (1/16 C).
+     */
+    int16_t mean() const
+    {
+      if (m_count == 0) return (0);
+      return (m_sum / m_count);
+    }
+
+  protected:
+    /** Sample ring. */
+    int16_t m_sample[N];
+
+    /** Number of samples in ring. */
+    uint8_t m_count;
+
+    /** Next sample position in ring. */
+    uint8_t m_next;
+
+    /** Number of samples added since decimation. */
+    uint8_t m_added;
+
+    /** Sum of samples in ring. */
+    int32_t m_sum;
+  };
+
   /**
    * Get conversion resolution.
    * @return number of bits.
@@ -186,39 +317,67 @@ public:
   {
     if (match && !m_owi.match_rom(m_rom)) return (false);
     m_owi.write(READ_SCRATCHPAD);
-    return (m_owi.read(&m_scratchpad, sizeof(m_scratchpad)));
+    if (!m_owi.read(&m_scratchpad, sizeof(m_scratchpad))) return (false);
+    bind();
+    memcpy(m_config, &m_scratchpad.high_trigger, CONFIG_MAX);
+    m_shadow |= CONFIG_VALID;
+    if (m_shadow & RECALLED) {
+      memcpy(m_eeprom, m_config, CONFIG_MAX);
+      m_shadow = CONFIG_VALID | EEPROM_VALID;
+    }
+    return (true);
   }
 
   /**
    * Write the contents of the scratchpad triggers and configuration
-   * (3 bytes) to device. Call with match parameter false if used with
-   * search_rom().
+   * (3 bytes) to device. The write is skipped if the device with the
+   * current rom code is known to have the same configuration. Call
+   * with match parameter false if used with search_rom().
    * @param[in] match rom code (default true).
    * @return true(1) if successful otherwise false(0).
    */
   bool write_scratchpad(bool match = true)
   {
+    bind();
+    if ((m_shadow & CONFIG_VALID)
+	&& !memcmp(m_config, &m_scratchpad.high_trigger, CONFIG_MAX))
+      return (true);
     if (match && !m_owi.match_rom(m_rom)) return (false);
     m_owi.write(WRITE_SCRATCHPAD, &m_scratchpad.high_trigger, CONFIG_MAX);
+    memcpy(m_config, &m_scratchpad.high_trigger, CONFIG_MAX);
+    m_shadow |= CONFIG_VALID;
     return (true);
   }
 
   /**
    * Copy device scratchpad triggers and configuration data to device
-   * EEPROM. Call with match parameter false if used with search_rom().
+   * EEPROM. The copy is skipped if the EEPROM of the device with the
+   * current rom code is known to hold the same configuration. Call
+   * with match parameter false if used with search_rom().
    * @param[in] match rom code (default true).
    * @return true(1) if successful otherwise false(0).
    */
   bool copy_scratchpad(bool match = true)
   {
+    const uint8_t VALID = (CONFIG_VALID | EEPROM_VALID);
+    bind();
+    if (((m_shadow & VALID) == VALID)
+	&& !memcmp(m_config, m_eeprom, CONFIG_MAX))
+      return (true);
     if (match && !m_owi.match_rom(m_rom)) return (false);
     m_owi.write(COPY_SCRATCHPAD);
+    if (m_shadow & CONFIG_VALID) {
+      memcpy(m_eeprom, m_config, CONFIG_MAX);
+      m_shadow |= EEPROM_VALID;
+    }
     return (true);
   }
 
   /**
    * Recall the alarm triggers and configuration from device EEPROM.
-   * Call with match parameter false if used with search_rom().
+   * The next read_scratchpad() will confirm both the scratchpad and
+   * EEPROM configuration. Call with match parameter false if used
+   * with search_rom().
    * @param[in] match rom code (default true).
    * @return true(1) if successful otherwise false(0).
    */
@@ -226,9 +385,133 @@ public:
   {
     if (match && !m_owi.match_rom(m_rom)) return (false);
     m_owi.write(RECALL_E);
+    bind();
+    m_shadow = RECALLED;
     return (true);
   }
 
+  /**
+   * Update device scratchpad and EEPROM with the triggers and
+   * configuration. The device configuration is recalled and read if
+   * not known. Only differing values are written, and copied to
+   * EEPROM. Should be used in setup to avoid EEPROM writes on every
+   * boot.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool configure()
+  {
+    bind();
+    if ((m_shadow & EEPROM_VALID) == 0) {
+      uint8_t config[CONFIG_MAX];
+      memcpy(config, &m_scratchpad.high_trigger, CONFIG_MAX);
+      if (!recall()) return (false);
+      if (!read_scratchpad()) return (false);
+      memcpy(&m_scratchpad.high_trigger, config, CONFIG_MAX);
+    }
+    if (!write_scratchpad()) return (false);
+    return (copy_scratchpad());
+  }
+
+  /**
+   * Write the scratchpad triggers and configuration to all devices on
+   * the bus with a single skip_rom() broadcast, and optionally copy to
+   * EEPROM. Use when several devices share the same configuration.
+   * Only the configuration shadow of this device is updated.
+   * @param[in] copy to EEPROM (default false).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool broadcast_scratchpad(bool copy = false)
+  {
+    if (!m_owi.skip_rom()) return (false);
+    m_owi.write(WRITE_SCRATCHPAD, &m_scratchpad.high_trigger, CONFIG_MAX);
+    bind();
+    memcpy(m_config, &m_scratchpad.high_trigger, CONFIG_MAX);
+    m_shadow = CONFIG_VALID;
+    if (!copy) return (true);
+    if (!m_owi.skip_rom()) return (false);
+    m_owi.write(COPY_SCRATCHPAD);
+    memcpy(m_eeprom, m_config, CONFIG_MAX);
+    m_shadow = CONFIG_VALID | EEPROM_VALID;
+    return (true);
+  }
+
+  /**
+   * Set alarm trigger window around the latest temperature reading
+   * and write the triggers to the device scratchpad. The low and high
+   * thresholds are set to the whole degree reading minus and plus the
+   * given band. The device will signal alarm on the next conversion
+   * if the temperature has moved out of the window. Call with match
+   * parameter false if used with search_rom().
+   * @param[in] band width in degrees (default 1).
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool window(uint8_t band = 1, bool match = true)
+  {
+    int16_t value = (m_scratchpad.temperature >> 4);
+    int16_t low = value - band;
+    int16_t high = value + band;
+    if (low < -128) low = -128;
+    if (high > 127) high = 127;
+    set_trigger(low, high);
+    return (write_scratchpad(match));
+  }
+
+  /**
+   * Alarm search for the next device with a temperature outside its
+   * trigger window, read the scratchpad and move the window around
+   * the new reading. Only devices with changed temperature are read.
+   * Use after a broadcast convert_request() and conversion delay.
+   * The device rom code buffer is used for the search. Return
+   * position of difference or negative error code as alarm_search().
+   * @param[in] last position of discrepancy (default FIRST).
+   * @param[in] band width in degrees (default 1).
+   * @return position of difference or negative error code.
+   */
+  int8_t alarm_update(int8_t last = OWI::FIRST, uint8_t band = 1)
+  {
+    last = m_owi.alarm_search(m_rom, last);
+    if (last == OWI::ERROR) return (OWI::ERROR);
+    if (!read_scratchpad(false)) return (OWI::ERROR);
+    if (!window(band)) return (OWI::ERROR);
+    return (last);
+  }
+
+  /**
+   * Function line time cost model (us) for the given bus manager;
+   * see OWI::Cost.
+   * @param[in] BUS bus manager class.
+   */
+  template<typename BUS>
+  class Cost {
+  public:
+    /** Convert request; match rom, or skip rom for broadcast. */
+    static constexpr uint32_t convert_request(bool broadcast = false)
+    {
+      return (OWI::Cost<BUS>::function(1, 0, !broadcast));
+    }
+
+    /** Read scratchpad; match rom (or after search), and scratchpad. */
+    static constexpr uint32_t read_scratchpad(bool match = true)
+    {
+      return (match ?
+	      OWI::Cost<BUS>::function(1, sizeof(scratchpad_t)) :
+	      OWI::Cost<BUS>::write(1) + OWI::Cost<BUS>::read(sizeof(scratchpad_t)));
+    }
+
+    /** Write scratchpad; match rom and configuration. */
+    static constexpr uint32_t write_scratchpad()
+    {
+      return (OWI::Cost<BUS>::function(1 + CONFIG_MAX, 0));
+    }
+
+    /** Conversion time (us) for given resolution (default 12 bits). */
+    static constexpr uint32_t conversion(uint8_t bits = 12)
+    {
+      return ((MAX_CONVERSION_TIME * 1000UL) >> (12 - bits));
+    }
+  };
+
 protected:
   /**
    * DS18B20 Function Commands (Table 3, pp. 12).
@@ -263,5 +546,39 @@ protected:
 
   /** Convert request pending. */
   bool m_converting;
+
+  /** Configuration shadow state. */
+  enum {
+    CONFIG_VALID = 0x01,	//!< Device scratchpad configuration known.
+    EEPROM_VALID = 0x02,	//!< Device EEPROM configuration known.
+    RECALLED = 0x04		//!< Scratchpad recalled from EEPROM.
+  } __attribute__((packed));
+  uint8_t m_shadow;
+
+  /** Last known device scratchpad configuration. */
+  uint8_t m_config[CONFIG_MAX];
+
+  /** Last known device EEPROM configuration. */
+  uint8_t m_eeprom[CONFIG_MAX];
+
+  /** Rom code of the device the shadow belongs to. */
+  uint8_t m_shadow_rom[OWI::ROM_MAX];
+
+  /**
+   * Bind the configuration shadow to the current device rom code.
+   * The shadow is cleared if it belongs to another device; one driver
+   * instance may be used for several devices with search_rom(),
+   * alarm_search() or a rom code table. The shadow is also cleared
+   * when invalidated, see OWI::Device::invalidate(); e.g. when the
+   * device may have been power cycled and the scratchpad reloaded
+   * from EEPROM.
+   */
+  void bind()
+  {
+    if (invalidated()) m_shadow = 0;
+    if (!memcmp(m_shadow_rom, m_rom, OWI::ROM_MAX)) return;
+    memcpy(m_shadow_rom, m_rom, OWI::ROM_MAX);
+    m_shadow = 0;
+  }
 };
 #endif
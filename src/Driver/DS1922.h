@@ -0,0 +1,433 @@
+/**
+ * @file Driver/DS1922.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef OWI_DRIVER_DS1922_H
+#define OWI_DRIVER_DS1922_H
+
+#include "OWI.h"
+
+/**
+ * Driver for the DS1922 Temperature Logger iButton (Thermochron),
+ * and DS1923 Hygrochron. Memory is read with a single read memory
+ * stream; the inverted CRC16 at the end of each page is verified and
+ * the page is delivered to a given sink function. The stream is
+ * restarted at a failed page; pages already delivered are not read
+ * again. The mission log (8 KB) may be downloaded without buffering
+ * more than a page. Register and mission status reads use the same
+ * stream. Registers are written through the scratchpad.
+ *
+ * @section References
+ * 1. Maxim Integrated DS1922L/DS1922T Datasheet (REV: 19-4990; 9/15).
+ */
+class DS1922 : public OWI::Device {
+public:
+  /** Device family code. */
+  static const uint8_t FAMILY_CODE = 0x41;
+
+  /** Memory page size in bytes. */
+  static const uint8_t PAGE_MAX = 32;
+
+  /** Password size in bytes. */
+  static const uint8_t PASSWORD_MAX = 8;
+
+  /** Register page address. */
+  static const uint16_t REGISTER_START = 0x0200;
+
+  /** Data log memory address. */
+  static const uint16_t LOG_START = 0x1000;
+
+  /** Data log memory size in bytes. */
+  static const uint16_t LOG_MAX = 8192;
+
+  /** Max number of retries of a failed page. */
+  static const uint8_t RETRY_MAX = 3;
+
+  /**
+   * Memory sink function; receives memory pages in address order.
+   * The first and last page may be partial. Return false(0) to stop
+   * the stream.
+   * @param[in] env sink environment.
+   * @param[in] addr memory address.
+   * @param[in] buf data.
+   * @param[in] count number of bytes.
+   * @return true(1) to continue otherwise false(0).
+   */
+  typedef bool (*sink_t)(void* env, uint16_t addr, const uint8_t* buf,
+			 uint8_t count);
+
+  /**
+   * Construct a DS1922 device connected to the given 1-Wire bus.
+   * @param[in] owi bus manager.
+   * @param[in] rom code (default NULL).
+   */
+  DS1922(OWI& owi, uint8_t* rom = NULL) :
+    OWI::Device(owi, rom)
+  {
+    memset(m_password, 0, sizeof(m_password));
+    memset(&m_registers, 0, sizeof(m_registers));
+  }
+
+  /**
+   * Set password used for memory and mission functions. The password
+   * is ignored by the device when password protection is disabled.
+   * @param[in] pw password (PASSWORD_MAX bytes).
+   */
+  void password(const uint8_t* pw)
+  {
+    memcpy(m_password, pw, sizeof(m_password));
+  }
+
+  /**
+   * Read given number of bytes from memory address and deliver
+   * verified pages to given sink function. Failed pages are read
+   * again (max RETRY_MAX times). Return number of bytes delivered or
+   * negative error code.
+   * @param[in] addr memory address.
+   * @param[in] count number of bytes.
+   * @param[in] sink function.
+   * @param[in] env sink environment.
+   * @return number of bytes or negative error code.
+   */
+  int32_t read_memory(uint16_t addr, uint32_t count, sink_t sink, void* env)
+  {
+    uint8_t page[PAGE_MAX];
+    uint32_t res = 0;
+    uint8_t retry = RETRY_MAX;
+    bool restart = true;
+    while (count != 0) {
+      uint8_t n = PAGE_MAX - (addr & (PAGE_MAX - 1));
+
+      // Start stream with command, address and password, or continue
+      // with the next page
+      uint8_t cmd[] = {
+	READ_MEMORY_CRC, (uint8_t) addr, (uint8_t) (addr >> 8)
+      };
+      OWI::segment_t tx[] = {
+	{ OWI::TX_WRITE | OWI::TX_CRC16 | OWI::TX_RESTART, sizeof(cmd), cmd },
+	{ OWI::TX_WRITE, sizeof(m_password), m_password },
+	{ OWI::TX_READ | OWI::TX_CRC16, n, page },
+	{ OWI::TX_CHECK | OWI::TX_CRC16, 0, NULL }
+      };
+      const OWI::segment_t* sp = tx;
+      uint8_t segs = sizeof(tx) / sizeof(tx[0]);
+      if (!restart) {
+	tx[2].op |= OWI::TX_RESTART;
+	sp += 2;
+	segs -= 2;
+      }
+      else if (!m_owi.match_rom(m_rom)) return (-1);
+      restart = !m_owi.transfer(sp, segs);
+      if (restart) {
+	if (--retry == 0) return (-1);
+	continue;
+      }
+      retry = RETRY_MAX;
+
+      // Deliver verified page
+      if (n > count) n = count;
+      if (!sink(env, addr, page, n)) break;
+      addr += n;
+      res += n;
+      count -= n;
+    }
+    return (res);
+  }
+
+  /**
+   * Read given number of bytes from memory address to given buffer.
+   * Uses the same page stream as the sink read.
+   * @param[in] addr memory address.
+   * @param[in] buf buffer.
+   * @param[in] count number of bytes.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool read_memory(uint16_t addr, void* buf, size_t count)
+  {
+    return (read_memory(addr, count, copy, &buf) == (int32_t) count);
+  }
+
+  /**
+   * Download data log; given number of bytes from start of log
+   * memory, to given sink function. Return number of bytes delivered
+   * or negative error code.
+   * @param[in] sink function.
+   * @param[in] env sink environment.
+   * @param[in] count number of bytes (default LOG_MAX).
+   * @return number of bytes or negative error code.
+   */
+  int32_t read_log(sink_t sink, void* env, uint16_t count = LOG_MAX)
+  {
+    if (count > LOG_MAX) count = LOG_MAX;
+    return (read_memory(LOG_START, count, sink, env));
+  }
+
+  /**
+   * Write given number of bytes from buffer to memory address; write
+   * scratchpad, read back and verify with CRC16, and copy with
+   * password. Used for the mission setup registers.
+   * @param[in] addr memory address.
+   * @param[in] buf buffer.
+   * @param[in] count number of bytes.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool write_memory(uint16_t addr, const void* buf, size_t count)
+  {
+    const uint8_t* bp = (const uint8_t*) buf;
+    while (count != 0) {
+      uint8_t n = PAGE_MAX - (addr & (PAGE_MAX - 1));
+      if (n > count) n = count;
+      if (!write_scratchpad(addr, bp, n)) return (false);
+      addr += n;
+      bp += n;
+      count -= n;
+    }
+    return (true);
+  }
+
+  /**
+   * Read register page and mission sample counters.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool read_status()
+  {
+    return (read_memory(REGISTER_START, &m_registers, sizeof(m_registers)));
+  }
+
+  /**
+   * Check mission in progress from the latest status read.
+   * @return true(1) if mission in progress otherwise false(0).
+   */
+  bool mission_in_progress() const
+  {
+    return ((m_registers.general_status & MIP) != 0);
+  }
+
+  /**
+   * Get mission control register from the latest status read.
+   * @return mission control.
+   */
+  uint8_t mission_control() const
+  {
+    return (m_registers.mission_control);
+  }
+
+  /**
+   * Get number of mission samples from the latest status read.
+   * @return mission samples.
+   */
+  uint32_t mission_samples() const
+  {
+    return (m_registers.mission_samples[0]
+	    | ((uint32_t) m_registers.mission_samples[1] << 8)
+	    | ((uint32_t) m_registers.mission_samples[2] << 16));
+  }
+
+  /**
+   * Get number of temperature log bytes from the latest status read;
+   * mission samples and sample size. The log is full when the mission
+   * has rolled over. The temperature log is half the log memory when
+   * humidity logging is enabled.
+   * @return number of bytes.
+   */
+  uint16_t log_size() const
+  {
+    uint8_t control = m_registers.mission_control;
+    if ((control & ETL) == 0) return (0);
+    uint16_t max = (control & EHL) ? LOG_MAX / 2 : LOG_MAX;
+    uint32_t res = mission_samples() * ((control & TLFS) ? 2 : 1);
+    return (res < max ? res : max);
+  }
+
+  /**
+   * Clear data log memory and mission registers. Requires that no
+   * mission is in progress.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool clear_memory()
+  {
+    if (!function(CLEAR_MEMORY)) return (false);
+    return (read_status() && (m_registers.general_status & MEMCLR));
+  }
+
+  /**
+   * Start mission with the current mission setup registers. Requires
+   * that the memory has been cleared.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool start_mission()
+  {
+    if (!function(START_MISSION)) return (false);
+    return (read_status() && mission_in_progress());
+  }
+
+  /**
+   * Stop mission in progress.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool stop_mission()
+  {
+    if (!function(STOP_MISSION)) return (false);
+    return (read_status() && !mission_in_progress());
+  }
+
+protected:
+  /**
+   * DS1922 Memory and Control Function Commands (Figure 11, pp. 26).
+   */
+  enum {
+    WRITE_SCRATCHPAD = 0x0F,	//!< Write scratchpad.
+    READ_SCRATCHPAD = 0xAA,	//!< Read scratchpad with address and status.
+    COPY_SCRATCHPAD = 0x99,	//!< Copy scratchpad with password.
+    READ_MEMORY_CRC = 0x69,	//!< Read memory with password and CRC16.
+    CLEAR_MEMORY = 0x96,	//!< Clear memory with password.
+    START_MISSION = 0xCC,	//!< Start mission with password.
+    STOP_MISSION = 0x33		//!< Stop mission with password.
+  } __attribute__((packed));
+
+  /**
+   * Mission Control Register bits (0x0213).
+   */
+  enum {
+    ETL = 0x01,			//!< Enable temperature logging.
+    EHL = 0x02,			//!< Enable humidity logging.
+    TLFS = 0x04,		//!< Temperature log 16-bit samples.
+    HLFS = 0x08,		//!< Humidity log 16-bit samples.
+    RO = 0x10,			//!< Rollover enable.
+    SUTA = 0x20			//!< Start upon temperature alarm.
+  } __attribute__((packed));
+
+  /**
+   * General Status Register bits (0x0215).
+   */
+  enum {
+    MIP = 0x02,			//!< Mission in progress.
+    MEMCLR = 0x08,		//!< Memory cleared.
+    WFTA = 0x10			//!< Waiting for temperature alarm.
+  } __attribute__((packed));
+
+  /**
+   * Register page and mission sample counters (0x0200..0x0225).
+   */
+  struct registers_t {
+    uint8_t rtc[6];		//!< Real-time clock.
+    uint8_t sample_rate[2];	//!< Sample rate.
+    uint8_t temperature_alarm[2]; //!< Temperature low/high alarm.
+    uint8_t humidity_alarm[2];	//!< Humidity low/high alarm.
+    uint8_t temperature[2];	//!< Latest temperature.
+    uint8_t humidity[2];	//!< Latest humidity.
+    uint8_t temperature_alarm_enable; //!< Temperature alarm enable.
+    uint8_t humidity_alarm_enable; //!< Humidity alarm enable.
+    uint8_t rtc_control;	//!< Real-time clock control.
+    uint8_t mission_control;	//!< Mission control.
+    uint8_t alarm_status;	//!< Alarm status.
+    uint8_t general_status;	//!< General status.
+    uint8_t start_delay[3];	//!< Mission start delay.
+    uint8_t mission_timestamp[6]; //!< Mission start time.
+    uint8_t reserved;		//!< Reserved.
+    uint8_t mission_samples[3];	//!< Mission samples counter.
+    uint8_t device_samples[3];	//!< Device samples counter.
+  };
+
+  /** Password. */
+  uint8_t m_password[PASSWORD_MAX];
+
+  /** Latest status read. */
+  registers_t m_registers;
+
+  /**
+   * Memory sink function; copy to buffer. The environment is a
+   * pointer to the buffer pointer.
+   * @param[in] env buffer pointer reference.
+   * @param[in] addr memory address.
+   * @param[in] buf data.
+   * @param[in] count number of bytes.
+   * @return true(1).
+   */
+  static bool copy(void* env, uint16_t addr, const uint8_t* buf,
+		   uint8_t count)
+  {
+    (void) addr;
+    uint8_t** dp = (uint8_t**) env;
+    memcpy(*dp, buf, count);
+    *dp += count;
+    return (true);
+  }
+
+  /**
+   * Write given number of bytes within a page to memory address
+   * through the scratchpad; write, read back and verify, and copy
+   * with password.
+   * @param[in] addr memory address.
+   * @param[in] buf data.
+   * @param[in] count number of bytes (within page).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool write_scratchpad(uint16_t addr, const uint8_t* buf, uint8_t count)
+  {
+    // Write scratchpad; check sum is only returned for a full page
+    if (!m_owi.match_rom(m_rom)) return (false);
+    uint8_t cmd[] = { WRITE_SCRATCHPAD, (uint8_t) addr, (uint8_t) (addr >> 8) };
+    OWI::segment_t wr[] = {
+      { OWI::TX_WRITE, sizeof(cmd), cmd },
+      { OWI::TX_WRITE, count, (void*) buf }
+    };
+    if (!m_owi.transfer(wr, sizeof(wr) / sizeof(wr[0]))) return (false);
+
+    // Read scratchpad; verify address, ending offset and data
+    if (!m_owi.match_rom(m_rom)) return (false);
+    uint8_t op = READ_SCRATCHPAD;
+    uint8_t auth[3];
+    uint8_t data[PAGE_MAX];
+    OWI::segment_t rd[] = {
+      { OWI::TX_WRITE | OWI::TX_CRC16, 1, &op },
+      { OWI::TX_READ | OWI::TX_CRC16, sizeof(auth), auth },
+      { OWI::TX_READ | OWI::TX_CRC16, count, data },
+      { OWI::TX_CHECK | OWI::TX_CRC16, 0, NULL }
+    };
+    if (!m_owi.transfer(rd, sizeof(rd) / sizeof(rd[0]))) return (false);
+    if (memcmp(auth, &cmd[1], 2)) return (false);
+    if ((auth[2] & 0x7f) != ((addr + count - 1) & (PAGE_MAX - 1))) return (false);
+    if (memcmp(data, buf, count)) return (false);
+
+    // Copy scratchpad with authorization and password
+    if (!m_owi.match_rom(m_rom)) return (false);
+    op = COPY_SCRATCHPAD;
+    OWI::segment_t cp[] = {
+      { OWI::TX_WRITE, 1, &op },
+      { OWI::TX_WRITE, sizeof(auth), auth },
+      { OWI::TX_WRITE, sizeof(m_password), m_password }
+    };
+    if (!m_owi.transfer(cp, sizeof(cp) / sizeof(cp[0]))) return (false);
+    uint8_t res = m_owi.read();
+    return (res == 0xAA || res == 0x55);
+  }
+
+  /**
+   * Issue given mission control function with password.
+   * @param[in] cmd function command.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool function(uint8_t cmd)
+  {
+    if (!m_owi.match_rom(m_rom)) return (false);
+    m_owi.write(cmd, m_password, sizeof(m_password));
+    m_owi.write(0xff);
+    return (true);
+  }
+};
+#endif
@@ -0,0 +1,287 @@
+/**
+ * @file Driver/DS2408.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef OWI_DRIVER_DS2408_H
+#define OWI_DRIVER_DS2408_H
+
+#include "OWI.h"
+
+/**
+ * Driver for the DS2408 1-Wire 8-Channel Addressable Switch.
+ * Supports register read, channel access read streaming, channel
+ * access write with confirmation, and conditional search setup.
+ *
+ * @section Circuit
+ * @code
+ *                           DS2408
+ *                       +------------+
+ * (VCC)--[4K7]--+     1-|RSTZ    P0  |-16
+ * (Dn)----------+-----2-|IO      P1  |-15
+ *                     3-|NC      P2  |-14
+ * (GND)---------------4-|GND     P3  |-13
+ *                     5-|P7      VCC |-12--(VCC)
+ *                     6-|P6      NC  |-11
+ *                     7-|P5      NC  |-10
+ *                     8-|P4      NC  |-9
+ *                       +------------+
+ * @endcode
+ *
+ * @section References
+ * 1. Maxim Integrated DS2408 Datasheet (REV: 19-5702; 12/10).
+ */
+class DS2408 : public OWI::Device {
+public:
+  /** Device family code. */
+  static const uint8_t FAMILY_CODE = 0x29;
+
+  /** Channel access read block size; check sum after each block. */
+  static const uint8_t BLOCK_MAX = 32;
+
+  /**
+   * Construct a DS2408 device connected to the given 1-Wire bus.
+   * @param[in] owi bus manager.
+   * @param[in] rom code (default NULL).
+   */
+  DS2408(OWI& owi, uint8_t* rom = NULL) :
+    OWI::Device(owi, rom),
+    m_crc(0),
+    m_count(0)
+  {
+    memset(&m_registers, 0, sizeof(m_registers));
+  }
+
+  /**
+   * Get PIO logic state from the latest register read.
+   * @return pin state.
+   */
+  uint8_t pio_state() const
+  {
+    return (m_registers.pio_state);
+  }
+
+  /**
+   * Get PIO output latch state from the latest register read.
+   * @return output latch.
+   */
+  uint8_t output_latch() const
+  {
+    return (m_registers.output_latch);
+  }
+
+  /**
+   * Get PIO activity latch state from the latest register read.
+   * @return activity latch.
+   */
+  uint8_t activity_latch() const
+  {
+    return (m_registers.activity_latch);
+  }
+
+  /**
+   * Get control/status register from the latest register read.
+   * @return control/status.
+   */
+  uint8_t control_status() const
+  {
+    return (m_registers.control_status);
+  }
+
+  /**
+   * Read PIO registers (0x88..0x8F) and verify the inverted CRC16.
+   * Call with match parameter false if used with search_rom().
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool read_registers(bool match = true)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (false);
+    uint8_t cmd[] = { READ_PIO_REGISTERS, PIO_STATE, 0x00 };
+    OWI::segment_t tx[] = {
+      { OWI::TX_WRITE | OWI::TX_CRC16, sizeof(cmd), cmd },
+      { OWI::TX_READ | OWI::TX_CRC16, sizeof(m_registers), &m_registers },
+      { OWI::TX_CHECK | OWI::TX_CRC16, 0, NULL }
+    };
+    return (m_owi.transfer(tx, sizeof(tx) / sizeof(tx[0])));
+  }
+
+  /**
+   * Start channel access read streaming. Each byte read with
+   * channel_read() is a new sample of the PIO pins, without
+   * addressing the device again. Call with match parameter false
+   * if used with search_rom().
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool channel_read_begin(bool match = true)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (false);
+    m_owi.write(CHANNEL_ACCESS_READ);
+    m_crc = OWI::crc16_update(0, CHANNEL_ACCESS_READ);
+    m_count = 0;
+    return (true);
+  }
+
+  /**
+   * Read given number of PIO samples to given buffer. Channel access
+   * read streaming must be started with channel_read_begin(). The
+   * inverted CRC16 after each block of BLOCK_MAX samples is read
+   * and verified; the first check sum includes the command byte.
+   * The stream must be restarted on check sum error.
+   * @param[in] buf sample buffer.
+   * @param[in] count number of samples.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool channel_read(uint8_t* buf, size_t count)
+  {
+    while (count--) {
+      uint8_t value = m_owi.read();
+      *buf++ = value;
+      m_crc = OWI::crc16_update(m_crc, value);
+      if (++m_count < BLOCK_MAX) continue;
+      uint16_t crc = m_owi.read();
+      crc |= (m_owi.read() << 8);
+      if (crc != (uint16_t) ~m_crc) return (false);
+      m_crc = 0;
+      m_count = 0;
+    }
+    return (true);
+  }
+
+  /**
+   * Write given value to the PIO output latch and read back the PIO
+   * pin state to given variable, if not null. The write is
+   * confirmed by the device. Call with match parameter false if
+   * used with search_rom().
+   * @param[in] value output latch.
+   * @param[out] state pin state (default NULL).
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool channel_write(uint8_t value, uint8_t* state = NULL, bool match = true)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (false);
+    m_owi.write(CHANNEL_ACCESS_WRITE);
+    m_owi.write(value);
+    m_owi.write(~value);
+    if (m_owi.read() != CONFIRM) return (false);
+    uint8_t res = m_owi.read();
+    if (state != NULL) *state = res;
+    m_registers.output_latch = value;
+    return (true);
+  }
+
+  /**
+   * Set conditional search; channel selection mask and polarity, and
+   * control; activity latch or pin state, and AND or OR of the
+   * selected channels. The power-on reset latch is cleared. The
+   * device will respond to alarm_search() when the condition is
+   * met; activity latches are reset with reset_activity_latches().
+   * Call with match parameter false if used with search_rom().
+   * @param[in] mask channel selection mask.
+   * @param[in] polarity channel polarity selection.
+   * @param[in] activity latch select (default true).
+   * @param[in] all channels condition (AND) (default false).
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool conditional_search(uint8_t mask, uint8_t polarity,
+			  bool activity = true, bool all = false,
+			  bool match = true)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (false);
+    uint8_t control = (m_registers.control_status & ROS);
+    if (activity) control |= PLS;
+    if (all) control |= CT;
+    uint8_t cmd[] = {
+      WRITE_CONDITIONAL_SEARCH, SEARCH_MASK, 0x00, mask, polarity, control
+    };
+    m_owi.write(cmd[0], &cmd[1], sizeof(cmd) - 1);
+    m_registers.search_mask = mask;
+    m_registers.search_polarity = polarity;
+    m_registers.control_status = control;
+    return (true);
+  }
+
+  /**
+   * Reset PIO activity latches. Call with match parameter false if
+   * used with search_rom().
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool reset_activity_latches(bool match = true)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (false);
+    m_owi.write(RESET_ACTIVITY_LATCHES);
+    if (m_owi.read() != CONFIRM) return (false);
+    m_registers.activity_latch = 0;
+    return (true);
+  }
+
+protected:
+  /**
+   * DS2408 Function Commands (Table 2, pp. 13).
+   */
+  enum {
+    READ_PIO_REGISTERS = 0xF0,	//!< Read PIO registers with CRC16.
+    CHANNEL_ACCESS_READ = 0xF5,	//!< Channel access read streaming.
+    CHANNEL_ACCESS_WRITE = 0x5A, //!< Channel access write.
+    WRITE_CONDITIONAL_SEARCH = 0xCC, //!< Write conditional search registers.
+    RESET_ACTIVITY_LATCHES = 0xC3, //!< Reset activity latches.
+    CONFIRM = 0xAA		//!< Confirmation byte.
+  } __attribute__((packed));
+
+  /**
+   * DS2408 Register Addresses (Table 1, pp. 9).
+   */
+  enum {
+    PIO_STATE = 0x88,		//!< PIO logic state.
+    SEARCH_MASK = 0x8B		//!< Conditional search channel mask.
+  } __attribute__((packed));
+
+  /**
+   * DS2408 Control/Status Register bits.
+   */
+  enum {
+    PLS = 0x01,			//!< Pin or activity latch select.
+    CT = 0x02,			//!< Conditional search logical term (AND).
+    ROS = 0x04,			//!< RSTZ pin mode (strobe output).
+    PORL = 0x08,		//!< Power-on reset latch.
+    VCCP = 0x80			//!< VCC power status.
+  } __attribute__((packed));
+
+  /**
+   * DS2408 PIO Registers (0x88..0x8F).
+   */
+  struct registers_t {
+    uint8_t pio_state;		//!< PIO logic state.
+    uint8_t output_latch;	//!< PIO output latch state.
+    uint8_t activity_latch;	//!< PIO activity latch state.
+    uint8_t search_mask;	//!< Conditional search channel mask.
+    uint8_t search_polarity;	//!< Conditional search polarity.
+    uint8_t control_status;	//!< Control/status register.
+    uint8_t reserved[2];	//!< Reserved (0xff).
+  } __attribute__((packed));
+  registers_t m_registers;
+
+  /** Channel access read check sum. */
+  uint16_t m_crc;
+
+  /** Channel access read samples in current block. */
+  uint8_t m_count;
+};
+#endif
@@ -0,0 +1,113 @@
+/**
+ * @file Driver/DS2409.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef OWI_DRIVER_DS2409_H
+#define OWI_DRIVER_DS2409_H
+
+#include "OWI.h"
+
+/**
+ * Driver for the DS2409 MicroLAN Coupler. The coupler connects the
+ * trunk to the main or auxiliary branch. The coupler is always
+ * accessible on the trunk. See Coupler::OWI for branch topology.
+ *
+ * @section References
+ * 1. Maxim Integrated DS2409 Datasheet (REV: 19-4988; 10/09).
+ */
+class DS2409 : public OWI::Device {
+public:
+  /** Device family code. */
+  static const uint8_t FAMILY_CODE = 0x1F;
+
+  /**
+   * Construct a DS2409 device connected to the given 1-Wire bus.
+   * @param[in] owi bus manager.
+   * @param[in] rom code (default NULL).
+   */
+  DS2409(OWI& owi, const uint8_t* rom = NULL) :
+    OWI::Device(owi, rom)
+  {
+  }
+
+  /**
+   * Disconnect main and auxiliary branches. Call with match parameter
+   * false if used with search_rom().
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool all_lines_off(bool match = true)
+  {
+    return (command(ALL_LINES_OFF, match));
+  }
+
+  /**
+   * Connect main branch without reset on branch. Call with match
+   * parameter false if used with search_rom().
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool direct_on_main(bool match = true)
+  {
+    return (command(DIRECT_ON_MAIN, match));
+  }
+
+  /**
+   * Connect main or auxiliary branch with reset on branch, and check
+   * for presence on branch. Call with match parameter false if used
+   * with search_rom().
+   * @param[in] aux auxiliary branch if true(1) otherwise main branch.
+   * @param[out] presence on branch (default NULL).
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool smart_on(bool aux, bool* presence = NULL, bool match = true)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (false);
+    uint8_t cmd = aux ? SMART_ON_AUX : SMART_ON_MAIN;
+    m_owi.write(cmd);
+    uint8_t res = m_owi.read();
+    if (presence != NULL) *presence = (res != 0xff);
+    return (m_owi.read() == cmd);
+  }
+
+protected:
+  /**
+   * DS2409 Control Function Commands (Table 2, pp. 7). The command
+   * code is returned as confirmation.
+   */
+  enum {
+    ALL_LINES_OFF = 0x66,	//!< Disconnect branches.
+    DIRECT_ON_MAIN = 0xA5,	//!< Connect main branch.
+    SMART_ON_MAIN = 0xCC,	//!< Reset and connect main branch.
+    SMART_ON_AUX = 0x33		//!< Reset and connect auxiliary branch.
+  } __attribute__((packed));
+
+  /**
+   * Issue given command and check confirmation.
+   * @param[in] cmd command.
+   * @param[in] match rom code.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool command(uint8_t cmd, bool match)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (false);
+    m_owi.write(cmd);
+    return (m_owi.read() == cmd);
+  }
+};
+#endif
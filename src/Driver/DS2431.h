@@ -0,0 +1,305 @@
+/**
+ * @file Driver/DS2431.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef OWI_DRIVER_DS2431_H
+#define OWI_DRIVER_DS2431_H
+
+#include "OWI.h"
+
+/**
+ * Driver for the DS2431 1024-Bit 1-Wire EEPROM. Memory is read
+ * with a single read memory transaction, and written in rows of the
+ * scratchpad size (8 bytes) through the scratchpad; write, verify
+ * (CRC16) and copy. Rows are
+ * addressed with resume after the first match. Pages may be cached
+ * in a given buffer; cached pages are read without bus access.
+ *
+ * @section Circuit
+ * @code
+ *                           DS2431
+ *                       +------------+
+ * (VCC)--[4K7]--+     1-|IO          |
+ * (Dn)----------+-----+ |            |
+ * (GND)---------------2-|GND         |
+ *                       +------------+
+ * @endcode
+ *
+ * @section References
+ * 1. Maxim Integrated DS2431 Datasheet (REV: 19-5052; 11/09).
+ */
+class DS2431 : public OWI::Device {
+public:
+  /** Device family code. */
+  static const uint8_t FAMILY_CODE = 0x2D;
+
+  /** Memory size in bytes. */
+  static const uint16_t MEMORY_MAX = 128;
+
+  /** Memory page size in bytes. */
+  static const uint8_t PAGE_MAX = 32;
+
+  /** Scratchpad (row) size in bytes. */
+  static const uint8_t ROW_MAX = 8;
+
+  /** Max scratchpad size of devices with the same commands. */
+  static const uint8_t SCRATCHPAD_MAX = 32;
+
+  /** Max copy scratchpad programming time in milli-seconds. */
+  static const uint8_t PROGRAM_TIME = 10;
+
+  /** Max number of cached pages. */
+  static const uint8_t CACHE_MAX = 32;
+
+  /**
+   * Construct a DS2431 device connected to the given 1-Wire bus.
+   * @param[in] owi bus manager.
+   * @param[in] rom code (default NULL).
+   */
+  DS2431(OWI& owi, uint8_t* rom = NULL) :
+    OWI::Device(owi, rom),
+    m_size(MEMORY_MAX),
+    m_row(ROW_MAX),
+    m_cache(NULL),
+    m_pages(0),
+    m_valid(0)
+  {
+  }
+
+  /**
+   * Set page cache; buffer for the given number of pages from the
+   * start of memory. The cache is invalidated.
+   * @param[in] pages cache buffer.
+   * @param[in] count number of pages.
+   */
+  void cache(uint8_t (*pages)[PAGE_MAX], uint8_t count)
+  {
+    uint8_t max = m_size / PAGE_MAX;
+    if (count > max) count = max;
+    if (count > CACHE_MAX) count = CACHE_MAX;
+    m_cache = pages;
+    m_pages = count;
+    m_valid = 0;
+  }
+
+  /**
+   * Load all cached pages with a single read memory transaction.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool load()
+  {
+    if (invalidated()) m_valid = 0;
+    if (m_pages == 0) return (true);
+    if (!read_memory(0, m_cache, m_pages * PAGE_MAX)) return (false);
+    m_valid = (m_pages == CACHE_MAX) ? 0xffffffffUL : (1UL << m_pages) - 1;
+    return (true);
+  }
+
+  /**
+   * Read given number of bytes from memory address to given buffer.
+   * Cached pages are read from the cache, otherwise the range is
+   * read with a single read memory transaction and covered cache
+   * pages are updated. Return number of bytes read if successful,
+   * otherwise negative error code.
+   * @param[in] dest buffer.
+   * @param[in] src memory address.
+   * @param[in] count number of bytes.
+   * @return number of bytes or negative error code.
+   */
+  int read(void* dest, uint16_t src, size_t count)
+  {
+    if (count == 0 || src + count > m_size) return (-1);
+    if (invalidated()) m_valid = 0;
+    if (cached(src, count)) {
+      uint8_t* dp = (uint8_t*) dest;
+      for (size_t n = count; n != 0; n--, src++)
+	*dp++ = m_cache[src / PAGE_MAX][src & (PAGE_MAX - 1)];
+      return (count);
+    }
+    if (!read_memory(src, dest, count)) return (-1);
+    uint8_t page = (src + PAGE_MAX - 1) / PAGE_MAX;
+    for (; page < m_pages && (size_t) (page + 1) * PAGE_MAX <= src + count; page++) {
+      memcpy(m_cache[page], (uint8_t*) dest + page * PAGE_MAX - src, PAGE_MAX);
+      m_valid |= (1UL << page);
+    }
+    return (count);
+  }
+
+  /**
+   * Write given number of bytes from buffer to memory address. The
+   * data is written in rows through the scratchpad; partial rows are
+   * merged with the current memory contents. Each row is verified
+   * before copy. Cached pages are updated. Return number of bytes
+   * written if successful, otherwise negative error code.
+   * @param[in] dest memory address.
+   * @param[in] src buffer.
+   * @param[in] count number of bytes.
+   * @return number of bytes or negative error code.
+   */
+  int write(uint16_t dest, const void* src, size_t count)
+  {
+    if (count == 0 || dest + count > m_size) return (-1);
+    if (invalidated()) m_valid = 0;
+    const uint8_t* sp = (const uint8_t*) src;
+    bool match = true;
+    for (size_t n = count; n != 0;) {
+      uint16_t addr = dest & ~(m_row - 1);
+      uint8_t offset = dest - addr;
+      uint8_t size = m_row - offset;
+      if (size > n) size = n;
+      uint8_t row[SCRATCHPAD_MAX];
+      if (size != m_row && read(row, addr, m_row) < 0) return (-1);
+      memcpy(row + offset, sp, size);
+      if (!write_row(addr, row, match)) return (-1);
+      match = false;
+      uint8_t page = addr / PAGE_MAX;
+      if (page < m_pages && (m_valid & (1UL << page)))
+	memcpy(&m_cache[page][addr & (PAGE_MAX - 1)], row, m_row);
+      dest += size;
+      sp += size;
+      n -= size;
+    }
+    return (count);
+  }
+
+protected:
+  /**
+   * DS2431 Memory Function Commands (Figure 7, pp. 9).
+   */
+  enum {
+    WRITE_SCRATCHPAD = 0x0F,	//!< Write scratchpad (8 bytes).
+    READ_SCRATCHPAD = 0xAA,	//!< Read scratchpad with address and status.
+    COPY_SCRATCHPAD = 0x55,	//!< Copy scratchpad to memory.
+    READ_MEMORY = 0xF0,		//!< Read memory.
+    COPY_DONE = 0xAA		//!< Copy completed.
+  } __attribute__((packed));
+
+  /** Memory size in bytes. */
+  uint16_t m_size;
+
+  /** Scratchpad (row) size in bytes. */
+  uint8_t m_row;
+
+  /** Page cache buffer. */
+  uint8_t (*m_cache)[PAGE_MAX];
+
+  /** Number of cached pages. */
+  uint8_t m_pages;
+
+  /** Cache valid pages mask. */
+  uint32_t m_valid;
+
+  /**
+   * Construct device with given memory and scratchpad size. Used by
+   * drivers for devices with the same memory function commands.
+   * @param[in] owi bus manager.
+   * @param[in] rom code.
+   * @param[in] size memory size in bytes.
+   * @param[in] row scratchpad size in bytes (max SCRATCHPAD_MAX).
+   */
+  DS2431(OWI& owi, uint8_t* rom, uint16_t size, uint8_t row) :
+    OWI::Device(owi, rom),
+    m_size(size),
+    m_row(row),
+    m_cache(NULL),
+    m_pages(0),
+    m_valid(0)
+  {
+  }
+
+  /**
+   * Check if given memory range is in valid cached pages.
+   * @param[in] addr memory address.
+   * @param[in] count number of bytes.
+   * @return true(1) if cached otherwise false(0).
+   */
+  bool cached(uint16_t addr, size_t count)
+  {
+    uint8_t last = (addr + count - 1) / PAGE_MAX;
+    if (last >= m_pages) return (false);
+    for (uint8_t page = addr / PAGE_MAX; page <= last; page++)
+      if ((m_valid & (1UL << page)) == 0) return (false);
+    return (true);
+  }
+
+  /**
+   * Read given number of bytes from memory address to given buffer
+   * with a single read memory transaction. The device read memory
+   * command has no check sum.
+   * @param[in] addr memory address.
+   * @param[in] buf buffer.
+   * @param[in] count number of bytes.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool read_memory(uint16_t addr, void* buf, size_t count)
+  {
+    if (!m_owi.match_rom(m_rom)) return (false);
+    uint8_t cmd[] = { (uint8_t) addr, (uint8_t) (addr >> 8) };
+    m_owi.write(READ_MEMORY, cmd, sizeof(cmd));
+    m_owi.read(buf, count);
+    return (true);
+  }
+
+  /**
+   * Write row to given memory address; write scratchpad with CRC16
+   * check, read back and verify scratchpad, and copy to memory. The
+   * device is addressed with match rom, or resume.
+   * @param[in] addr memory address (row aligned).
+   * @param[in] row data (scratchpad size bytes).
+   * @param[in] match rom code, otherwise resume.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool write_row(uint16_t addr, const uint8_t* row, bool match)
+  {
+    // Write scratchpad and verify check sum
+    if (match) {
+      if (!m_owi.match_rom(m_rom)) return (false);
+    }
+    else {
+      if (!m_owi.resume()) return (false);
+    }
+    uint8_t cmd[] = { WRITE_SCRATCHPAD, (uint8_t) addr, (uint8_t) (addr >> 8) };
+    OWI::segment_t wr[] = {
+      { OWI::TX_WRITE | OWI::TX_CRC16, sizeof(cmd), cmd },
+      { OWI::TX_WRITE | OWI::TX_CRC16, m_row, (void*) row },
+      { OWI::TX_CHECK | OWI::TX_CRC16, 0, NULL }
+    };
+    if (!m_owi.transfer(wr, sizeof(wr) / sizeof(wr[0]))) return (false);
+
+    // Read scratchpad; verify address, status and data
+    if (!m_owi.resume()) return (false);
+    uint8_t op = READ_SCRATCHPAD;
+    uint8_t auth[3];
+    uint8_t data[SCRATCHPAD_MAX];
+    OWI::segment_t rd[] = {
+      { OWI::TX_WRITE | OWI::TX_CRC16, 1, &op },
+      { OWI::TX_READ | OWI::TX_CRC16, sizeof(auth), auth },
+      { OWI::TX_READ | OWI::TX_CRC16, m_row, data },
+      { OWI::TX_CHECK | OWI::TX_CRC16, 0, NULL }
+    };
+    if (!m_owi.transfer(rd, sizeof(rd) / sizeof(rd[0]))) return (false);
+    if (memcmp(auth, &cmd[1], 2) || auth[2] != m_row - 1) return (false);
+    if (memcmp(data, row, m_row)) return (false);
+
+    // Copy scratchpad with authorization and wait for completion
+    if (!m_owi.resume()) return (false);
+    m_owi.write(COPY_SCRATCHPAD, auth, sizeof(auth));
+    delay(PROGRAM_TIME);
+    return (m_owi.read() == COPY_DONE);
+  }
+};
+#endif
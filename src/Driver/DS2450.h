@@ -0,0 +1,377 @@
+/**
+ * @file Driver/DS2450.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef OWI_DRIVER_DS2450_H
+#define OWI_DRIVER_DS2450_H
+
+#include "OWI.h"
+
+/**
+ * Driver for the DS2450 1-Wire Quad A/D Converter. All channels are
+ * converted with a single convert command, optionally broadcast, and
+ * read with a single memory read with CRC16 check. The channel
+ * resolution and input range are kept in a control page shadow, and
+ * only changed control bytes are written to the device.
+ *
+ * @section Circuit
+ * @code
+ *                           DS2450
+ *                       +------------+
+ * (VCC)---------------1-|VCC     GND |-8---(GND)
+ * (VCC)--[4K7]--+     2-|NC      AIND|-7
+ * (Dn)----------+-----3-|DQ      AINC|-6
+ *                     4-|GND     AINB|-5
+ *                       +------------+
+ *                                 AINA
+ * @endcode
+ *
+ * @section References
+ * 1. Maxim Integrated DS2450 Datasheet (REV: 19-4845; 11/09).
+ */
+class DS2450 : public OWI::Device {
+public:
+  /** Device family code. */
+  static const uint8_t FAMILY_CODE = 0x20;
+
+  /** Number of channels. */
+  static const uint8_t CHANNEL_MAX = 4;
+
+  /** Memory page size in bytes. */
+  static const uint8_t PAGE_MAX = 8;
+
+  /**
+   * Construct a DS2450 device connected to the given 1-Wire bus.
+   * Initiate with 16-bit resolution and 5.12 V input range for all
+   * channels.
+   * @param[in] owi bus manager.
+   * @param[in] rom code (default NULL).
+   */
+  DS2450(OWI& owi, uint8_t* rom = NULL) :
+    OWI::Device(owi, rom),
+    m_start(0),
+    m_mask(0),
+    m_converting(false),
+    m_shadow(false)
+  {
+    memset(m_value, 0, sizeof(m_value));
+    memset(m_control, 0, sizeof(m_control));
+    resolution(16);
+    range(true);
+  }
+
+  /**
+   * Set conversion resolution (1..16 bits) for the given channels.
+   * Use configure() to update device.
+   * @param[in] bits resolution.
+   * @param[in] mask channel mask (default all).
+   */
+  void resolution(uint8_t bits, uint8_t mask = 0x0f)
+  {
+    if (bits < 1) bits = 1; else if (bits > 16) bits = 16;
+    for (uint8_t chan = 0; chan < CHANNEL_MAX; chan++, mask >>= 1) {
+      if ((mask & 0x01) == 0) continue;
+      uint8_t& control = m_control[chan * 2];
+      control = (control & ~RC_MASK) | (bits & RC_MASK);
+    }
+  }
+
+  /**
+   * Get conversion resolution for the given channel.
+   * @param[in] chan channel (0..3).
+   * @return resolution.
+   */
+  uint8_t channel_resolution(uint8_t chan) const
+  {
+    uint8_t bits = m_control[chan * 2] & RC_MASK;
+    return (bits == 0 ? 16 : bits);
+  }
+
+  /**
+   * Set input range, 5.12 V or 2.56 V, for the given channels. Use
+   * configure() to update device.
+   * @param[in] high range 5.12 V if true(1) otherwise 2.56 V.
+   * @param[in] mask channel mask (default all).
+   */
+  void range(bool high, uint8_t mask = 0x0f)
+  {
+    for (uint8_t chan = 0; chan < CHANNEL_MAX; chan++, mask >>= 1) {
+      if ((mask & 0x01) == 0) continue;
+      uint8_t& control = m_control[chan * 2 + 1];
+      if (high) control |= IR; else control &= ~IR;
+    }
+  }
+
+  /**
+   * Write control page (resolution and range) to device. Only the
+   * bytes that differ from the known device control page are
+   * written; the device control page is read if not known. The
+   * power-on reset flag is cleared. Call with match parameter false
+   * if used with search_rom().
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool configure(bool match = true)
+  {
+    if (invalidated()) m_shadow = false;
+    if (!m_shadow) {
+      if (!read_memory(CONTROL_PAGE, m_device, PAGE_MAX, match)) return (false);
+      m_shadow = true;
+      match = true;
+    }
+    uint8_t first = PAGE_MAX;
+    uint8_t last = 0;
+    for (uint8_t i = 0; i < PAGE_MAX; i++) {
+      if (m_control[i] == m_device[i]) continue;
+      if (first == PAGE_MAX) first = i;
+      last = i;
+    }
+    if (first == PAGE_MAX) return (true);
+    uint8_t count = last - first + 1;
+    if (!write_memory(CONTROL_PAGE + first, &m_control[first], count, match)) {
+      m_shadow = false;
+      return (false);
+    }
+    memcpy(&m_device[first], &m_control[first], count);
+    return (true);
+  }
+
+  /**
+   * Initiate conversion of the given channels. Call with broadcast
+   * parameter true(1) to issue skip_rom() and issue the command to
+   * all devices.
+   * @param[in] mask channel mask (default all).
+   * @param[in] broadcast flag (default false).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool convert_request(uint8_t mask = 0x0f, bool broadcast = false)
+  {
+    if (broadcast) {
+      if (!m_owi.skip_rom()) return (false);
+    }
+    else {
+      if (!m_owi.match_rom(m_rom)) return (false);
+    }
+    uint8_t cmd[] = { CONVERT, (uint8_t) (mask & 0x0f), 0x00 };
+    OWI::segment_t tx[] = {
+      { OWI::TX_WRITE | OWI::TX_CRC16, sizeof(cmd), cmd },
+      { OWI::TX_CHECK | OWI::TX_CRC16, 0, NULL }
+    };
+    if (!m_owi.transfer(tx, sizeof(tx) / sizeof(tx[0]))) return (false);
+    m_start = millis();
+    m_mask = mask;
+    m_converting = true;
+    return (true);
+  }
+
+  /**
+   * Return remaining conversion time in milliseconds. Max conversion
+   * time is 80 us per bit and 160 us offset per channel.
+   * @return milliseconds remaining.
+   */
+  uint16_t conversion_time()
+  {
+    if (!m_converting) return (0);
+    m_converting = false;
+    uint16_t us = 0;
+    uint8_t mask = m_mask;
+    for (uint8_t chan = 0; chan < CHANNEL_MAX; chan++, mask >>= 1)
+      if (mask & 0x01) us += channel_resolution(chan) * 80 + 160;
+    uint16_t conv_ms = (us + 999) / 1000;
+    uint16_t ms = millis() - m_start;
+    if (conv_ms > ms) return (conv_ms - ms);
+    return (0);
+  }
+
+  /**
+   * Check if the conversion is completed. The device holds the bus
+   * low during conversion (VCC powered).
+   * @return true(1) if ready otherwise false(0).
+   */
+  bool convert_ready()
+  {
+    if (!m_converting) return (true);
+    bool res = m_owi.read(1);
+    if (res) m_converting = false;
+    return (res);
+  }
+
+  /**
+   * Delay until the conversion is completed by polling the device.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool convert_await()
+  {
+    if (!m_converting) return (false);
+    while (!convert_ready()) delay(1);
+    return (true);
+  }
+
+  /**
+   * Read conversion results for all channels with a single memory
+   * read and CRC16 check. Call with match parameter false if used
+   * with search_rom().
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool read_conversion(bool match = true)
+  {
+    return (read_memory(CONVERSION_PAGE, m_value, sizeof(m_value), match));
+  }
+
+  /**
+   * Get latest conversion result for given channel; MSB aligned
+   * 16-bit value.
+   * @param[in] chan channel (0..3).
+   * @return value.
+   */
+  uint16_t value(uint8_t chan) const
+  {
+    return (m_value[chan]);
+  }
+
+  /**
+   * Get latest conversion result for given channel in milli-volt.
+   * @param[in] chan channel (0..3).
+   * @return milli-volt.
+   */
+  uint16_t millivolt(uint8_t chan) const
+  {
+    uint32_t mv = (m_control[chan * 2 + 1] & IR) ? 5120 : 2560;
+    return ((mv * m_value[chan]) >> 16);
+  }
+
+protected:
+  /**
+   * DS2450 Memory Function Commands (Figure 8, pp. 10).
+   */
+  enum {
+    READ_MEMORY = 0xAA,		//!< Read memory with CRC16 per page.
+    WRITE_MEMORY = 0x55,	//!< Write memory with CRC16 and echo.
+    CONVERT = 0x3C		//!< Convert channels.
+  } __attribute__((packed));
+
+  /**
+   * DS2450 Memory Map (Figure 6, pp. 6).
+   */
+  enum {
+    CONVERSION_PAGE = 0x00,	//!< Conversion read-out.
+    CONTROL_PAGE = 0x08,	//!< Control/status data.
+    ALARM_PAGE = 0x10		//!< Alarm settings.
+  } __attribute__((packed));
+
+  /**
+   * DS2450 Control/Status Data bits (Figure 7, pp. 7).
+   */
+  enum {
+    RC_MASK = 0x0f,		//!< Resolution (0 for 16 bits).
+    OC = 0x40,			//!< Output control.
+    OE = 0x80,			//!< Output enable.
+    IR = 0x01,			//!< Input range 5.12 V.
+    POR = 0x80			//!< Power-on reset.
+  } __attribute__((packed));
+
+  /** Watchdog millis on convert_request(). */
+  uint16_t m_start;
+
+  /** Channel mask on convert_request(). */
+  uint8_t m_mask;
+
+  /** Convert request pending. */
+  bool m_converting;
+
+  /** Device control page known. */
+  bool m_shadow;
+
+  /** Latest conversion results. */
+  uint16_t m_value[CHANNEL_MAX];
+
+  /** Control page; requested configuration. */
+  uint8_t m_control[PAGE_MAX];
+
+  /** Control page; device shadow. */
+  uint8_t m_device[PAGE_MAX];
+
+  /**
+   * Read given number of bytes from memory address to given buffer.
+   * The inverted CRC16 at the end of each page is verified; the
+   * first check sum includes the command and address. The last page
+   * is read to the end for the check sum.
+   * @param[in] addr memory address.
+   * @param[in] buf buffer.
+   * @param[in] count number of bytes.
+   * @param[in] match rom code.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool read_memory(uint8_t addr, void* buf, uint8_t count, bool match)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (false);
+    uint8_t cmd[] = { READ_MEMORY, addr, 0x00 };
+    m_owi.write(cmd[0], &cmd[1], sizeof(cmd) - 1);
+    uint16_t crc = OWI::crc16(cmd, sizeof(cmd));
+    uint8_t* bp = (uint8_t*) buf;
+    while (count != 0) {
+      uint8_t n = PAGE_MAX - (addr & (PAGE_MAX - 1));
+      addr += n;
+      while (n--) {
+	uint8_t value = m_owi.read();
+	crc = OWI::crc16_update(crc, value);
+	if (count == 0) continue;
+	*bp++ = value;
+	count -= 1;
+      }
+      uint16_t res = m_owi.read();
+      res |= (m_owi.read() << 8);
+      if (res != (uint16_t) ~crc) return (false);
+      crc = 0;
+    }
+    return (true);
+  }
+
+  /**
+   * Write given number of bytes from buffer to memory address. Each
+   * byte is verified with the device CRC16 and echo; the first check
+   * sum includes the command and address, following the address and
+   * data byte.
+   * @param[in] addr memory address.
+   * @param[in] buf buffer.
+   * @param[in] count number of bytes.
+   * @param[in] match rom code.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool write_memory(uint8_t addr, const uint8_t* buf, uint8_t count,
+		    bool match)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (false);
+    uint8_t cmd[] = { WRITE_MEMORY, addr, 0x00 };
+    m_owi.write(cmd[0], &cmd[1], sizeof(cmd) - 1);
+    uint16_t crc = OWI::crc16(cmd, sizeof(cmd));
+    while (count--) {
+      uint8_t value = *buf++;
+      m_owi.write(value);
+      crc = OWI::crc16_update(crc, value);
+      uint16_t res = m_owi.read();
+      res |= (m_owi.read() << 8);
+      if (res != (uint16_t) ~crc) return (false);
+      if (m_owi.read() != value) return (false);
+      addr += 1;
+      crc = OWI::crc16_update(OWI::crc16_update(0, addr), 0x00);
+    }
+    return (true);
+  }
+};
+#endif
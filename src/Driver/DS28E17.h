@@ -0,0 +1,316 @@
+/**
+ * @file Driver/DS28E17.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef OWI_DRIVER_DS28E17_H
+#define OWI_DRIVER_DS28E17_H
+
+#include "OWI.h"
+#include "TWI.h"
+
+/**
+ * Driver for the DS28E17 1-Wire-to-I2C Master Bridge. Each I2C
+ * write, read, and write-read operation is issued as a single 1-Wire
+ * transaction with CRC16. Completion is detected by polling the busy
+ * bit instead of waiting the worst case I2C transfer time. The
+ * nested TWI class adapts the bridge to the TWI bus interface so that
+ * TWI device drivers may be used on the 1-Wire bus.
+ *
+ * @section References
+ * 1. Maxim Integrated DS28E17 Datasheet (REV: 19-7220; 4/16).
+ */
+class DS28E17 : public OWI::Device {
+public:
+  /** Device family code. */
+  static const uint8_t FAMILY_CODE = 0x19;
+
+  /** Max number of bytes in I2C write or read. */
+  static const uint8_t DATA_MAX = 255;
+
+  /** Max number of write buffers per operation. */
+  static const uint8_t IOV_MAX = 6;
+
+  /** Max I2C operation time in milli-seconds. */
+  static const uint8_t TIMEOUT = 32;
+
+  /** I2C clock speed (configuration). */
+  enum {
+    SPEED_100KHZ = 0,		//!< Standard mode.
+    SPEED_400KHZ = 1,		//!< Fast mode (default).
+    SPEED_900KHZ = 2		//!< Fast mode plus.
+  } __attribute__((packed));
+
+  /**
+   * Construct a DS28E17 device connected to the given 1-Wire bus.
+   * @param[in] owi bus manager.
+   * @param[in] rom code (default NULL).
+   */
+  DS28E17(OWI& owi, uint8_t* rom = NULL) :
+    OWI::Device(owi, rom),
+    m_status(0),
+    m_write_status(0)
+  {
+  }
+
+  /**
+   * Write given buffer to I2C device with given address, followed by
+   * stop condition.
+   * @param[in] addr I2C device address (7-bit).
+   * @param[in] buf buffer.
+   * @param[in] count number of bytes (1..DATA_MAX).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool write(uint8_t addr, const void* buf, uint8_t count)
+  {
+    OWI::segment_t wr = { OWI::TX_WRITE | OWI::TX_CRC16, count, (void*) buf };
+    return (request(WRITE_DATA_WITH_STOP, addr, &wr, 1, NULL, 0));
+  }
+
+  /**
+   * Read given number of bytes from I2C device with given address to
+   * buffer, followed by stop condition.
+   * @param[in] addr I2C device address (7-bit).
+   * @param[in] buf buffer.
+   * @param[in] count number of bytes (1..DATA_MAX).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool read(uint8_t addr, void* buf, uint8_t count)
+  {
+    return (request(READ_DATA_WITH_STOP, addr, NULL, 0, buf, count));
+  }
+
+  /**
+   * Write given source buffer to I2C device with given address, and
+   * read given number of bytes to destination buffer with repeated
+   * start, followed by stop condition. Typically used for register
+   * read.
+   * @param[in] addr I2C device address (7-bit).
+   * @param[in] src buffer.
+   * @param[in] n number of bytes to write (1..DATA_MAX).
+   * @param[in] dest buffer.
+   * @param[in] count number of bytes to read (1..DATA_MAX).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool write_read(uint8_t addr, const void* src, uint8_t n,
+		  void* dest, uint8_t count)
+  {
+    OWI::segment_t wr = { OWI::TX_WRITE | OWI::TX_CRC16, n, (void*) src };
+    return (request(WRITE_READ_DATA_WITH_STOP, addr, &wr, 1, dest, count));
+  }
+
+  /**
+   * Set I2C clock speed.
+   * @param[in] speed code (SPEED_100KHZ, SPEED_400KHZ, SPEED_900KHZ).
+   * @param[in] match rom code (default true).
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool write_configuration(uint8_t speed, bool match = true)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (false);
+    m_owi.write(WRITE_CONFIGURATION, &speed, sizeof(speed));
+    return (true);
+  }
+
+  /**
+   * Read I2C clock speed.
+   * @param[in] match rom code (default true).
+   * @return speed code or negative error code.
+   */
+  int read_configuration(bool match = true)
+  {
+    if (match && !m_owi.match_rom(m_rom)) return (-1);
+    m_owi.write(READ_CONFIGURATION);
+    return (m_owi.read() & SPEED_MASK);
+  }
+
+  /**
+   * Get status of latest I2C operation; bit mask with CRC error,
+   * address not acknowledged, and start condition error.
+   * @return status.
+   */
+  uint8_t status() const
+  {
+    return (m_status);
+  }
+
+  /**
+   * Get write status of latest I2C operation; zero if all bytes were
+   * acknowledged, otherwise the position of the first byte not
+   * acknowledged.
+   * @return write status.
+   */
+  uint8_t write_status() const
+  {
+    return (m_write_status);
+  }
+
+  /**
+   * TWI bus adapter. TWI device drivers may use the bridge through
+   * this interface. Each read and write is a bridge I2C operation
+   * with stop condition; write buffers are sent in a single 1-Wire
+   * transaction.
+   */
+  class TWI : public ::TWI {
+  public:
+    /**
+     * Construct TWI bus adapter for given bridge.
+     * @param[in] bridge device.
+     */
+    TWI(DS28E17& bridge) :
+      ::TWI(),
+      m_bridge(bridge)
+    {
+    }
+
+    /**
+     * @override{TWI}
+     * Read given number of bytes from device with given address to
+     * buffer. Return number of bytes read or negative error code.
+     * @param[in] addr device address.
+     * @param[in] buf buffer pointer.
+     * @param[in] count number of bytes.
+     * @return number of bytes or negative error code.
+     */
+    virtual int read(uint8_t addr, void* buf, size_t count)
+    {
+      if (count == 0 || count > DATA_MAX) return (-1);
+      if (!m_bridge.read(addr, buf, count)) return (-1);
+      return (count);
+    }
+
+    /**
+     * @override{TWI}
+     * Write given null terminated io vector to device with given
+     * address. Return number of bytes written or negative error code.
+     * An io vector without data is an error.
+     * @param[in] addr device address.
+     * @param[in] vp io vector pointer.
+     * @return number of bytes or negative error code.
+     */
+    virtual int write(uint8_t addr, iovec_t* vp)
+    {
+      OWI::segment_t wr[IOV_MAX];
+      uint8_t n = 0;
+      size_t count = 0;
+      for (; vp->buf != NULL; vp++) {
+	if (vp->size == 0) continue;
+	if (n == IOV_MAX) return (-1);
+	wr[n].op = OWI::TX_WRITE | OWI::TX_CRC16;
+	wr[n].count = vp->size;
+	wr[n].buf = vp->buf;
+	count += vp->size;
+	n += 1;
+      }
+      if (count == 0) return (-1);
+      if (!m_bridge.request(WRITE_DATA_WITH_STOP, addr, wr, n, NULL, 0))
+	return (-1);
+      return (count);
+    }
+
+  protected:
+    /** Bridge device. */
+    DS28E17& m_bridge;
+  };
+
+protected:
+  /**
+   * DS28E17 Device Function Commands (Table 2, pp. 10).
+   */
+  enum {
+    WRITE_DATA_WITH_STOP = 0x4B,	//!< Write with start and stop.
+    READ_DATA_WITH_STOP = 0x87,		//!< Read with start and stop.
+    WRITE_READ_DATA_WITH_STOP = 0x2D,	//!< Write, repeated start, read.
+    WRITE_CONFIGURATION = 0xD2,		//!< Write I2C speed.
+    READ_CONFIGURATION = 0xE1		//!< Read I2C speed.
+  } __attribute__((packed));
+
+  /** Configuration speed mask. */
+  static const uint8_t SPEED_MASK = 0x03;
+
+  /** Status of latest I2C operation. */
+  uint8_t m_status;
+
+  /** Write status of latest I2C operation. */
+  uint8_t m_write_status;
+
+  /**
+   * Issue I2C operation with given command and address; write the
+   * given data segments and/or read given number of bytes. The
+   * command, address, lengths and data are sent with inverted CRC16
+   * in a single 1-Wire transaction. The busy bit is polled until the
+   * I2C operation completes, then status, write status (if data was
+   * written), and data (if read) are received.
+   * @param[in] cmd function command.
+   * @param[in] addr I2C device address (7-bit).
+   * @param[in] wr data segments to write.
+   * @param[in] n number of data segments.
+   * @param[in] buf buffer for read data.
+   * @param[in] count number of bytes to read.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool request(uint8_t cmd, uint8_t addr,
+	       const OWI::segment_t* wr, uint8_t n,
+	       void* buf, uint8_t count)
+  {
+    // Check data length and build transaction
+    size_t size = 0;
+    for (uint8_t i = 0; i < n; i++) size += wr[i].count;
+    if (n != 0 && (size == 0 || size > DATA_MAX)) return (false);
+    if (cmd == WRITE_DATA_WITH_STOP && size == 0) return (false);
+    if (cmd != WRITE_DATA_WITH_STOP && count == 0) return (false);
+    uint8_t header[] = {
+      cmd, (uint8_t) ((addr << 1) | (cmd == READ_DATA_WITH_STOP))
+    };
+    uint8_t wlen = size;
+    OWI::segment_t tx[IOV_MAX + 4];
+    uint8_t ix = 0;
+    tx[ix].op = OWI::TX_WRITE | OWI::TX_CRC16;
+    tx[ix].count = sizeof(header);
+    tx[ix++].buf = header;
+    if (n != 0) {
+      tx[ix].op = OWI::TX_WRITE | OWI::TX_CRC16;
+      tx[ix].count = 1;
+      tx[ix++].buf = &wlen;
+      for (uint8_t i = 0; i < n; i++) tx[ix++] = wr[i];
+    }
+    if (count != 0) {
+      tx[ix].op = OWI::TX_WRITE | OWI::TX_CRC16;
+      tx[ix].count = 1;
+      tx[ix++].buf = &count;
+    }
+    tx[ix].op = OWI::TX_APPEND | OWI::TX_CRC16;
+    tx[ix].count = 0;
+    tx[ix++].buf = NULL;
+
+    // Issue transaction and poll busy bit for completion
+    if (!m_owi.match_rom(m_rom)) return (false);
+    if (!m_owi.transfer(tx, ix)) return (false);
+    uint32_t start = millis();
+    while (m_owi.read(1)) {
+      if (millis() - start > TIMEOUT) return (false);
+      yield();
+    }
+
+    // Receive status, write status and read data
+    m_status = m_owi.read();
+    m_write_status = (n != 0) ? m_owi.read() : 0;
+    if (m_status != 0 || m_write_status != 0) return (false);
+    if (count != 0) m_owi.read(buf, count);
+    return (true);
+  }
+};
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file Driver/DS28EC20.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef OWI_DRIVER_DS28EC20_H
+#define OWI_DRIVER_DS28EC20_H
+
+#include "OWI.h"
+#include "Driver/DS2431.h"
+
+/**
+ * Driver for the DS28EC20 20Kb 1-Wire EEPROM. Same scratchpad
+ * memory function commands as DS2431 with a 32 byte (page)
+ * scratchpad; memory is written in page rows. Memory is read with
+ * the extended read memory command; inverted CRC16 at the end of
+ * each page.
+ *
+ * @section References
+ * 1. Maxim Integrated DS28EC20 Datasheet (REV: 19-4616; 5/09).
+ */
+class DS28EC20 : public DS2431 {
+public:
+  /** Device family code. */
+  static const uint8_t FAMILY_CODE = 0x43;
+
+  /** Memory size in bytes. */
+  static const uint16_t MEMORY_MAX = 2560;
+
+  /** Scratchpad (row) size in bytes. */
+  static const uint8_t ROW_MAX = PAGE_MAX;
+
+  /**
+   * Construct a DS28EC20 device connected to the given 1-Wire bus.
+   * @param[in] owi bus manager.
+   * @param[in] rom code (default NULL).
+   */
+  DS28EC20(OWI& owi, uint8_t* rom = NULL) :
+    DS2431(owi, rom, MEMORY_MAX, ROW_MAX)
+  {
+  }
+
+protected:
+  /**
+   * DS28EC20 Extended Memory Function Command.
+   */
+  enum {
+    EXTENDED_READ_MEMORY = 0xA5	//!< Read memory with CRC16 per page.
+  } __attribute__((packed));
+
+  /**
+   * @override{DS2431}
+   * Read given number of bytes from memory address to given buffer
+   * with a single extended read memory transaction. The inverted
+   * CRC16 at the end of each page is verified; the first check sum
+   * includes the command and address. The last page is read to the
+   * end for the check sum.
+   * @param[in] addr memory address.
+   * @param[in] buf buffer.
+   * @param[in] count number of bytes.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool read_memory(uint16_t addr, void* buf, size_t count)
+  {
+    if (!m_owi.match_rom(m_rom)) return (false);
+    uint8_t cmd[] = {
+      EXTENDED_READ_MEMORY, (uint8_t) addr, (uint8_t) (addr >> 8)
+    };
+    m_owi.write(cmd[0], &cmd[1], sizeof(cmd) - 1);
+    uint16_t crc = OWI::crc16(cmd, sizeof(cmd));
+    uint8_t* bp = (uint8_t*) buf;
+    while (count != 0) {
+      uint8_t n = PAGE_MAX - (addr & (PAGE_MAX - 1));
+      addr += n;
+      while (n--) {
+	uint8_t value = m_owi.read();
+	crc = OWI::crc16_update(crc, value);
+	if (count == 0) continue;
+	*bp++ = value;
+	count -= 1;
+      }
+      uint16_t res = m_owi.read();
+      res |= (m_owi.read() << 8);
+      if (res != (uint16_t) ~crc) return (false);
+      crc = 0;
+    }
+    return (true);
+  }
+};
+#endif
@@ -24,7 +24,13 @@
 
 /**
  * One Wire Interface (OWI) Bus Manager class using DS2482,
- * Single-Channel 1-Wire Master, TWI to OWI Bridge Device.
+ * Single-Channel 1-Wire Master, TWI to OWI Bridge Device. The
+ * 1-wire operations may be queued as requests and completed by
+ * poll(), without waiting for the bridge. The TWI bus is only held
+ * during each command and status check, and may be shared with
+ * other devices while a 1-wire operation is in progress. The
+ * synchronous bus manager interface submits a request and polls
+ * until it is completed.
  */
 namespace Hardware {
 class OWI : public ::OWI {
@@ -35,19 +41,159 @@ public:
    * @param[in] subaddr sub-address for device.
    */
   OWI(TWI& twi, uint8_t subaddr = 0) :
-    m_bridge(twi, 0x18 | (subaddr & 0x03))
+    m_bridge(twi, 0x18 | (subaddr & 0x03)),
+    m_device(twi, 0x18 | (subaddr & 0x03)),
+    m_head(NULL),
+    m_tail(NULL),
+    m_busy(false),
+    m_start(0)
   {
   }
 
+  /**
+   * Request operations.
+   */
+  enum {
+    OP_RESET = 0,		//!< Reset, value is status.
+    OP_READ_BIT = 1,		//!< Read bit, value is status.
+    OP_WRITE_BIT = 2,		//!< Write bit value, value is status.
+    OP_READ_BYTE = 3,		//!< Read byte, value is byte read.
+    OP_WRITE_BYTE = 4,		//!< Write byte value, value is status.
+    OP_TRIPLET = 5		//!< Triplet direction, value is status.
+  } __attribute__((packed));
+
+  /**
+   * Request status.
+   */
+  enum {
+    REQUEST_DONE = 0,		//!< Request completed.
+    REQUEST_PENDING = 1,	//!< Request queued or in progress.
+    REQUEST_FAILED = -1,	//!< TWI bus error.
+    REQUEST_TIMEOUT = -2	//!< Bridge did not complete command.
+  } __attribute__((packed));
+
+  /**
+   * Max time (ms) for a command in progress. The longest command,
+   * reset with presence detect, is 1148 us at standard speed.
+   */
+  static const uint16_t REQUEST_TIMEOUT_MS = 10;
+
+  /**
+   * DS2482 status register bits.
+   */
+  enum {
+    STATUS_1WB = 0x01,		//!< 1-Wire busy.
+    STATUS_PPD = 0x02,		//!< Presence pulse detect.
+    STATUS_SD = 0x04,		//!< Short detected.
+    STATUS_LL = 0x08,		//!< Logic level.
+    STATUS_RST = 0x10,		//!< Device reset.
+    STATUS_SBR = 0x20,		//!< Single bit result.
+    STATUS_TSB = 0x40,		//!< Triplet second bit.
+    STATUS_DIR = 0x80		//!< Branch direction taken.
+  } __attribute__((packed));
+
+  /**
+   * Request (completion) descriptor. The request operation and
+   * value is given on submit(). On completion the status is set and
+   * the value is the status register, or the byte read.
+   */
+  struct request_t {
+    request_t* next;		//!< Next request in queue.
+    uint8_t op;			//!< Operation.
+    uint8_t value;		//!< Operation value or result.
+    volatile int8_t status;	//!< Request status.
+  };
+
+  /**
+   * Submit given request with operation and value. The request
+   * descriptor must remain valid until completed.
+   * @param[in] req request descriptor.
+   * @param[in] op operation.
+   * @param[in] value operation value (default 0).
+   */
+  void submit(request_t& req, uint8_t op, uint8_t value = 0)
+  {
+    req.next = NULL;
+    req.op = op;
+    req.value = value;
+    req.status = REQUEST_PENDING;
+    if (m_tail == NULL)
+      m_head = &req;
+    else
+      m_tail->next = &req;
+    m_tail = &req;
+  }
+
+  /**
+   * Advance the request queue; issue the next command or check the
+   * status of the command in progress and complete the request.
+   * A command that does not complete within REQUEST_TIMEOUT_MS is
+   * aborted with a bridge device reset and the request completed
+   * with REQUEST_TIMEOUT. Should be called periodically when requests
+   * are queued. Returns true(1) if there are requests in the queue,
+   * otherwise false(0).
+   * @return bool.
+   */
+  bool poll()
+  {
+    request_t* req = m_head;
+    if (req == NULL) return (false);
+    int res;
+    uint8_t status;
+    bool timeout = false;
+    m_device.acquire();
+    if (!m_busy) {
+      res = issue(req->op, req->value);
+      m_busy = (res >= 0);
+      m_start = millis();
+    }
+    else {
+      res = m_device.read(&status, sizeof(status));
+      if (res >= 0 && (status & STATUS_1WB) != 0) {
+	timeout = ((uint16_t) (((uint16_t) millis()) - m_start)
+		   >= REQUEST_TIMEOUT_MS);
+      }
+      else if (res >= 0) {
+	req->value = status;
+	if (req->op == OP_READ_BYTE) {
+	  static const uint8_t cmd[] = { SET_READ_POINTER, DATA_REGISTER };
+	  res = m_device.write(cmd, sizeof(cmd));
+	  if (res >= 0) res = m_device.read(&req->value, sizeof(req->value));
+	}
+	if (res >= 0) complete(REQUEST_DONE);
+      }
+    }
+    m_device.release();
+    if (timeout) {
+      m_bridge.device_reset();
+      complete(REQUEST_TIMEOUT);
+    }
+    else if (res < 0) complete(REQUEST_FAILED);
+    return (m_head != NULL);
+  }
+
   /**
    * @override{OWI}
    * Reset the one wire bus and check that at least one device is
-   * presence.
+   * presence. Fails fast, without accessing the bridge, during the
+   * backoff period after an empty or shorted bus. A failed or timed
+   * out bridge transfer is reported as BUS_ERROR; the backoff is not
+   * changed. See bus_state().
    * @return true(1) if successful otherwise false(0).
    */
   virtual bool reset()
   {
-    return (m_bridge.one_wire_reset());
+    if (backoff()) return (false);
+    request_t req;
+    if (execute(req, OP_RESET) != REQUEST_DONE)
+      bus_state(BUS_ERROR);
+    else if (req.value & STATUS_SD)
+      bus_state(BUS_SHORTED);
+    else if (req.value & STATUS_PPD)
+      bus_state(BUS_PRESENT);
+    else
+      bus_state(BUS_EMPTY);
+    return (m_bus_state == BUS_PRESENT);
   }
 
   /**
@@ -59,20 +205,19 @@ public:
    */
   virtual uint8_t read(uint8_t bits = CHARBITS)
   {
-    uint8_t res = 0;
+    request_t req;
     if (bits == CHARBITS) {
-      m_bridge.one_wire_read_byte(res);
+      execute(req, OP_READ_BYTE);
+      return (req.value);
     }
-    else {
-      uint8_t adjust = CHARBITS - bits;
-      bool value = 0;
-      while (bits--) {
-	res >>= 1;
-	m_bridge.one_wire_read_bit(value);
-	res |= (value ? 0x80 : 0x00);
-      }
-      res >>= adjust;
+    uint8_t adjust = CHARBITS - bits;
+    uint8_t res = 0;
+    while (bits--) {
+      res >>= 1;
+      execute(req, OP_READ_BIT, 0x80);
+      if (req.value & STATUS_SBR) res |= 0x80;
     }
+    res >>= adjust;
     return (res);
   }
 
@@ -85,14 +230,14 @@ public:
    */
   virtual void write(uint8_t value, uint8_t bits = CHARBITS)
   {
+    request_t req;
     if (bits == CHARBITS) {
-      m_bridge.one_wire_write_byte(value);
+      execute(req, OP_WRITE_BYTE, value);
+      return;
     }
-    else {
-      while (bits--) {
-	m_bridge.one_wire_write_bit(value & 0x01);
-	value >>= 1;
-      }
+    while (bits--) {
+      execute(req, OP_WRITE_BIT, (value & 0x01) ? 0x80 : 0x00);
+      value >>= 1;
     }
   }
 
@@ -107,7 +252,11 @@ public:
    */
   virtual int8_t triplet(uint8_t& dir)
   {
-    return (m_bridge.one_wire_triplet(dir));
+    request_t req;
+    if (execute(req, OP_TRIPLET, dir ? 0x80 : 0x00) != REQUEST_DONE)
+      return (0b11);
+    dir = (req.value & STATUS_DIR) != 0;
+    return ((req.value >> 5) & 0b11);
   }
 
   /**
@@ -144,8 +293,103 @@ public:
     return (m_bridge.channel_select(chan));
   }
 
+  /**
+   * Line time profile (us) for OWI::Cost; reset, bit, byte read and
+   * write, and search triplet. Standard speed 1-wire timing (reset
+   * 1148 us, slot 73 us) with the TWI command and status transfers
+   * at 100 kHz (TWI_BYTE, 9 clock cycles per byte).
+   */
+  static const uint16_t TWI_BYTE = 90;
+  static const uint16_t RESET_TIME = 1148 + 4 * TWI_BYTE;
+  static const uint16_t BIT_TIME = 73 + 5 * TWI_BYTE;
+  static const uint16_t READ_TIME = CHARBITS * 73 + 10 * TWI_BYTE;
+  static const uint16_t WRITE_TIME = CHARBITS * 73 + 5 * TWI_BYTE;
+  static const uint16_t TRIPLET_TIME = 3 * 73 + 5 * TWI_BYTE;
+
 protected:
+  /**
+   * DS2482 commands and registers.
+   */
+  enum {
+    ONE_WIRE_RESET = 0xb4,	//!< Generate reset pulse.
+    ONE_WIRE_SINGLE_BIT = 0x87,	//!< Generate single time slot.
+    ONE_WIRE_WRITE_BYTE = 0xa5,	//!< Write byte.
+    ONE_WIRE_READ_BYTE = 0x96,	//!< Read byte.
+    ONE_WIRE_TRIPLET = 0x78,	//!< Generate triplet time slots.
+    SET_READ_POINTER = 0xe1,	//!< Set read pointer.
+    STATUS_REGISTER = 0xf0,	//!< Status register.
+    DATA_REGISTER = 0xe1	//!< Read data register.
+  } __attribute__((packed));
+
+  /** Bridge device driver. */
   DS2482 m_bridge;
+
+  /** Bridge device for queued requests. */
+  ::TWI::Device m_device;
+
+  /** Request queue. */
+  request_t* m_head;
+  request_t* m_tail;
+
+  /** Command in progress for request at head of queue. */
+  bool m_busy;
+
+  /** Start time (ms) of command in progress. */
+  uint16_t m_start;
+
+  /**
+   * Write command for given operation and value. Read pointer is
+   * left at the status register.
+   * @param[in] op operation.
+   * @param[in] value operation value.
+   * @return number of bytes written or negative error code.
+   */
+  int issue(uint8_t op, uint8_t value)
+  {
+    static const uint8_t CMD[] PROGMEM = {
+      ONE_WIRE_RESET,
+      ONE_WIRE_SINGLE_BIT,
+      ONE_WIRE_SINGLE_BIT,
+      ONE_WIRE_READ_BYTE,
+      ONE_WIRE_WRITE_BYTE,
+      ONE_WIRE_TRIPLET
+    };
+    uint8_t cmd[2];
+    cmd[0] = pgm_read_byte(&CMD[op]);
+    cmd[1] = value;
+    size_t count = (op == OP_RESET || op == OP_READ_BYTE) ? 1 : 2;
+    return (m_device.write(cmd, count));
+  }
+
+  /**
+   * Complete request at head of queue with given status.
+   * @param[in] status request status.
+   */
+  void complete(int8_t status)
+  {
+    request_t* req = m_head;
+    m_head = req->next;
+    if (m_head == NULL) m_tail = NULL;
+    m_busy = false;
+    req->status = status;
+  }
+
+  /**
+   * Submit given request with operation and value, and poll until
+   * completed. Return request status. The wait is bounded; a TWI
+   * error fails the request, and a bridge that stays busy times out
+   * the request (see poll()).
+   * @param[in] req request descriptor.
+   * @param[in] op operation.
+   * @param[in] value operation value (default 0).
+   * @return request status.
+   */
+  int8_t execute(request_t& req, uint8_t op, uint8_t value = 0)
+  {
+    submit(req, op, value);
+    while (req.status == REQUEST_PENDING) poll();
+    return (req.status);
+  }
 };
 };
 #endif
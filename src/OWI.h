@@ -23,6 +23,24 @@
 #define CHARBITS 8
 #endif
 
+/**
+ * Reset backoff after an empty or shorted bus, see OWI::bus_state().
+ * Disabled by default; reset() always accesses the bus. Define as one
+ * before including the library to enable; reset() then fails fast
+ * without accessing the bus for a period that doubles from 4 ms to
+ * 1024 ms while the bus stays empty or shorted. Polling with a longer
+ * period than the backoff is not affected; otherwise call
+ * OWI::backoff_clear() before polling. Uses four bytes of data
+ * memory per bus manager.
+ */
+#ifndef OWI_BACKOFF
+#define OWI_BACKOFF 0
+#endif
+
+#if defined(ARDUINO_ARCH_AVR)
+#include <avr/eeprom.h>
+#endif
+
 /**
  * One Wire Interface (OWI) Bus Manager abstract class.
  */
@@ -34,10 +52,63 @@ public:
   /** One Wire device identity ROM size in bits. */
   static const size_t ROMBITS = ROM_MAX * CHARBITS;
 
+  /** Device rom code table; see below. */
+  class Table;
+
+  /** Resumable device enumeration; see Search/Cursor.h. */
+  class Cursor;
+
+  /** Device change monitor; see Search/Monitor.h. */
+  class Monitor;
+
+  /**
+   * Construct one wire bus manager.
+   */
+  OWI() :
+    m_bus_state(BUS_PRESENT)
+  {
+    backoff_clear();
+    search_stats_clear();
+  }
+
+  /**
+   * Bus state; result of latest reset.
+   */
+  enum {
+    BUS_PRESENT = 0,		//!< Device presence detected.
+    BUS_EMPTY = -2,		//!< No device presence.
+    BUS_SHORTED = -3,		//!< Bus held low before reset.
+    BUS_GLITCH = -4,		//!< Bus not released after presence.
+    BUS_ERROR = -5		//!< Bus adapter failure.
+  } __attribute__((packed));
+
+  /**
+   * Get bus state; result of latest reset. Returns BUS_PRESENT or
+   * negative error code.
+   * @return bus state.
+   */
+  int8_t bus_state() const
+  {
+    return (m_bus_state);
+  }
+
+  /**
+   * Clear reset backoff. Next reset() will access the bus. No
+   * operation unless OWI_BACKOFF is enabled.
+   */
+  void backoff_clear()
+  {
+#if OWI_BACKOFF
+    m_backoff = 0;
+#endif
+  }
+
   /**
    * @override{OWI}
    * Reset the one wire bus and check that at least one device is
-   * presence.
+   * presence. The result is recorded as the bus state. With
+   * OWI_BACKOFF enabled the reset fails fast, without accessing the
+   * bus, during the backoff period after an empty or shorted bus.
    * @return true(1) if successful otherwise false(0).
    */
   virtual bool reset() = 0;
@@ -54,7 +125,7 @@ public:
   /**
    * Read given number of bytes from one wire bus (device) to given
    * buffer. Calculates 8-bit Cyclic Redundancy Check sum and return
-   * result of check.
+   * result of check. The bytes are read with exchange().
    * @param[in] buf buffer pointer.
    * @param[in] count number of bytes to read.
    * @return true(1) if check sum is correct otherwise false(0).
@@ -62,12 +133,9 @@ public:
   bool read(void* buf, size_t count)
   {
     uint8_t* bp = (uint8_t*) buf;
+    if (!exchange(NULL, bp, count)) return (false);
     uint8_t crc = 0;
-    while (count--) {
-      uint8_t value = read();
-      *bp++ = value;
-      crc = crc_update(crc, value);
-    }
+    while (count--) crc = crc_update(crc, *bp++);
     return (crc == 0);
   }
 
@@ -82,7 +150,7 @@ public:
 
   /**
    * Write the given command and given number of bytes from buffer to
-   * the one wire bus (device).
+   * the one wire bus (device). The bytes are written with exchange().
    * @param[in] cmd command to write.
    * @param[in] buf buffer pointer.
    * @param[in] count number of bytes to write.
@@ -90,8 +158,82 @@ public:
   void write(uint8_t cmd, const void* buf, size_t count)
   {
     write(cmd);
-    const uint8_t* bp = (const uint8_t*) buf;
-    while (count--) write(*bp++);
+    exchange((const uint8_t*) buf, NULL, count);
+  }
+
+  /**
+   * Transaction segment operation and check sum mode. The check sum
+   * is accumulated over the segments with CRC8 or CRC16 mode, and
+   * restarted from zero by segments with TX_RESTART.
+   */
+  enum {
+    TX_WRITE = 0x00,		//!< Write buffer.
+    TX_READ = 0x01,		//!< Read buffer.
+    TX_CHECK = 0x02,		//!< Read and verify check sum.
+    TX_APPEND = 0x03,		//!< Write check sum.
+    TX_OP_MASK = 0x03,		//!< Operation mask.
+    TX_CRC8 = 0x04,		//!< 8-bit check sum mode.
+    TX_CRC16 = 0x08,		//!< 16-bit check sum mode (inverted).
+    TX_RESTART = 0x10		//!< Restart check sum.
+  } __attribute__((packed));
+
+  /**
+   * Transaction segment descriptor.
+   */
+  struct segment_t {
+    uint8_t op;			//!< Operation and check sum mode.
+    size_t count;		//!< Number of bytes (read/write).
+    void* buf;			//!< Buffer (read/write).
+  };
+
+  /**
+   * @override{OWI}
+   * Execute the given transaction; list of write and read segments
+   * with check sum checkpoints. Data is read and written directly
+   * from/to the segment buffers. A CRC16 checkpoint reads or writes
+   * the inverted check sum (LSB first) as 1-Wire memory devices.
+   * The transaction is aborted on the first check sum error. The
+   * read and write segments are transferred with exchange(); bus
+   * managers may override exchange() to pipeline block transfers.
+   * @param[in] seg transaction segments.
+   * @param[in] count number of segments.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool transfer(const segment_t* seg, uint8_t count)
+  {
+    uint16_t crc = 0;
+    for (; count != 0; count--, seg++) {
+      uint8_t op = seg->op;
+      uint8_t* bp = (uint8_t*) seg->buf;
+      size_t n = seg->count;
+      if (op & TX_RESTART) crc = 0;
+      switch (op & TX_OP_MASK) {
+      case TX_WRITE:
+	if (!exchange(bp, NULL, n)) return (false);
+	break;
+      case TX_READ:
+	if (!exchange(NULL, bp, n)) return (false);
+	break;
+      case TX_CHECK:
+	if (op & TX_CRC16) {
+	  uint16_t value = read();
+	  value |= (read() << 8);
+	  if (value != (uint16_t) ~crc) return (false);
+	}
+	else if (crc_update(crc, read()) != 0) return (false);
+	continue;
+      case TX_APPEND:
+	if (op & TX_CRC16) {
+	  crc = ~crc;
+	  write(crc);
+	  write(crc >> 8);
+	}
+	else write(crc);
+	continue;
+      }
+      while (n--) crc = tx_update(op, crc, *bp++);
+    }
+    return (true);
   }
 
   /**
@@ -131,6 +273,7 @@ public:
     MATCH_ROM = 0x55,		//!< Select device with 64-bit rom code.
     SKIP_ROM = 0xCC,		//!< Broadcast or single device.
     ALARM_SEARCH = 0xEC,	//!< Initiate device alarm search.
+    RESUME = 0xA5,		//!< Select latest matched device.
     LABEL_ROM = 0x15,		//!< Set short address (8-bit).
     MATCH_LABEL = 0x51		//!< Select device with 8-bit short address.
   } __attribute__((packed));
@@ -186,6 +329,43 @@ public:
     return (crc);
   }
 
+  /**
+   * Optimized Dallas/Maxim 16-bit Cyclic Redundancy Check
+   * calculation. Polynomial: x^16 + x^15 + x^2 + 1 (0xA001).
+   * See Maxim Application Note 27.
+   * @param[in] crc cyclic redundancy check sum.
+   * @param[in] data to append.
+   * @return crc.
+   */
+  static inline uint16_t crc16_update(uint16_t crc, uint8_t data)
+    __attribute__((always_inline))
+  {
+    crc = crc ^ data;
+    for (uint8_t i = 0; i < 8; i++) {
+      if (crc & 0x01)
+	crc = (crc >> 1) ^ 0xA001;
+      else
+	crc >>= 1;
+    }
+    return (crc);
+  }
+
+  /**
+   * Optimized Dallas/Maxim 16-bit Cyclic Redundancy Check
+   * calculation. Polynomial: x^16 + x^15 + x^2 + 1 (0xA001).
+   * @param[in] buf buffer pointer.
+   * @param[in] count number of bytes.
+   * @param[in] crc initial check sum (default 0).
+   * @return crc.
+   */
+  static inline uint16_t crc16(const void* buf, size_t count,
+			       uint16_t crc = 0)
+  {
+    const uint8_t* bp = (const uint8_t*) buf;
+    while (count--) crc = crc16_update(crc, *bp++);
+    return (crc);
+  }
+
   /** Search position and return values. */
   enum {
     FIRST = -1,			//!< Start position of search.
@@ -195,7 +375,9 @@ public:
 
   /**
    * Search device rom given the last position of discrepancy.
-   * Return position of difference or negative error code.
+   * Return position of difference or negative error code. The rom
+   * code check sum is verified, and the branch is searched again on
+   * error.
    * @param[in] family code.
    * @param[in] code device identity.
    * @param[in] last position of discrepancy (default FIRST).
@@ -204,9 +386,7 @@ public:
   int8_t search_rom(uint8_t family, uint8_t* code, int8_t last = FIRST)
   {
     do {
-      if (!reset()) return (ERROR);
-      write(SEARCH_ROM);
-      last = search(code, last);
+      last = search(SEARCH_ROM, code, last);
       if (last == ERROR) return (ERROR);
     } while ((last != LAST) && (family != 0) && (code[0] != family));
     if (family != 0 && code[0] != family) return (ERROR);
@@ -227,19 +407,39 @@ public:
   }
 
   /**
+   * @override{OWI}
    * Match device rom. Address the device with the rom code. Device
    * specific function command should follow. May be used to verify
-   * rom code.
+   * rom code. Bus managers may override to select the bus branch of
+   * the device, e.g. Coupler::OWI.
    * @param[in] code device identity.
    * @return true(1) if successful otherwise false(0).
    */
-  bool match_rom(uint8_t* code)
+  virtual bool match_rom(uint8_t* code)
   {
     if (!reset()) return (false);
     write(MATCH_ROM, code, ROM_MAX);
     return (true);
   }
 
+  /**
+   * Match device rom. Address the device with the given handle in
+   * the given rom code table. The rom code is copied from the table
+   * memory and matched with match_rom() so that bus manager overrides
+   * apply, e.g. branch selection. Device specific function command
+   * should follow.
+   * @param[in] table device rom code table.
+   * @param[in] handle device table index.
+   * @return true(1) if successful otherwise false(0).
+   */
+  bool match_rom(const Table& table, uint8_t handle)
+  {
+    uint8_t code[ROM_MAX];
+    if (handle >= table.count()) return (false);
+    table.rom(handle, code);
+    return (match_rom(code));
+  }
+
   /**
    * Skip device rom for boardcast or single device access.
    * Device specific function command should follow.
@@ -252,6 +452,21 @@ public:
     return (true);
   }
 
+  /**
+   * @override{OWI}
+   * Resume device access. Address the latest device selected with
+   * match_rom() without the rom code. Supported by devices with
+   * resume command, e.g. DS2431, DS28EC20. Device specific function
+   * command should follow.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool resume()
+  {
+    if (!reset()) return (false);
+    write(RESUME);
+    return (true);
+  }
+
   /**
    * Search alarming device given the last position of discrepancy.
    * @param[in] code device identity.
@@ -260,9 +475,7 @@ public:
    */
   int8_t alarm_search(uint8_t* code, int8_t last = FIRST)
   {
-    if (!reset()) return (ERROR);
-    write(ALARM_SEARCH);
-    return (search(code, last));
+    return (search(ALARM_SEARCH, code, last));
   }
 
   /**
@@ -279,6 +492,113 @@ public:
     return (true);
   }
 
+  /**
+   * One-Wire Interface (OWI) device rom code table. Devices are
+   * identified with a one byte handle (table index) and the rom codes
+   * are stored in data memory (SRAM), EEPROM (AVR only) or program
+   * memory (PROGMEM). A single device driver instance may be bound
+   * to a handle when accessing the device, see Device::rom(), so
+   * that the number of devices is not limited by driver instances in
+   * SRAM. An EEPROM table on other architectures is empty; count()
+   * is zero and matching a handle fails.
+   */
+  class Table {
+  public:
+    /** Table storage memory type. */
+    enum {
+      DATA_MEMORY = 0,		//!< Data memory (SRAM).
+      EEPROM_MEMORY = 1,	//!< EEPROM.
+      PROGRAM_MEMORY = 2	//!< Program memory (PROGMEM).
+    } __attribute__((packed));
+
+    /**
+     * Construct device rom code table with given storage, number of
+     * entries and memory type.
+     * @param[in] table rom codes (ROM_MAX bytes per entry).
+     * @param[in] count number of entries.
+     * @param[in] type of memory (default DATA_MEMORY).
+     */
+    Table(const void* table, uint8_t count, uint8_t type = DATA_MEMORY) :
+      m_table((const uint8_t*) table),
+      m_count(count),
+      m_type(type)
+    {
+#if !defined(ARDUINO_ARCH_AVR)
+      if (type == EEPROM_MEMORY) m_count = 0;
+#endif
+    }
+
+    /**
+     * Return number of entries.
+     * @return count.
+     */
+    uint8_t count() const
+    {
+      return (m_count);
+    }
+
+    /**
+     * Read byte with given index from rom code with given handle.
+     * Returns zero for an EEPROM table on other architectures than
+     * AVR.
+     * @param[in] handle device table index.
+     * @param[in] ix byte index.
+     * @return byte.
+     */
+    uint8_t read(uint8_t handle, uint8_t ix) const
+    {
+      const uint8_t* bp = m_table + handle * ROM_MAX + ix;
+      switch (m_type) {
+      case EEPROM_MEMORY:
+#if defined(ARDUINO_ARCH_AVR)
+	return (eeprom_read_byte(bp));
+#else
+	return (0);
+#endif
+      case PROGRAM_MEMORY:
+	return (pgm_read_byte(bp));
+      default:
+	return (*bp);
+      }
+    }
+
+    /**
+     * Copy rom code with given handle to given buffer.
+     * @param[in] handle device table index.
+     * @param[out] code device identity buffer.
+     */
+    void rom(uint8_t handle, uint8_t* code) const
+    {
+      for (uint8_t i = 0; i < ROM_MAX; i++) *code++ = read(handle, i);
+    }
+
+    /**
+     * Find handle for given rom code. Returns handle or negative
+     * error code if not found.
+     * @param[in] code device identity.
+     * @return handle or negative error code.
+     */
+    int16_t find(const uint8_t* code) const
+    {
+      for (uint8_t handle = 0; handle < m_count; handle++) {
+	uint8_t i = 0;
+	while (i < ROM_MAX && read(handle, i) == code[i]) i++;
+	if (i == ROM_MAX) return (handle);
+      }
+      return (-1);
+    }
+
+  protected:
+    /** Rom code table. */
+    const uint8_t* m_table;
+
+    /** Number of entries. */
+    uint8_t m_count;
+
+    /** Memory type. */
+    uint8_t m_type;
+  };
+
   /**
    * One-Wire Interface (OWI) Device Driver abstract class.
    */
@@ -291,13 +611,15 @@ public:
      * @param[in] rom code (default NULL).
      */
     Device(OWI& owi, const uint8_t* rom = NULL) :
-      m_owi(owi)
+      m_owi(owi),
+      m_invalidated(false)
     {
       if (rom != NULL) this->rom(rom);
     }
 
     /**
-     * Set device rom code.
+     * Set device rom code. Driver state that belongs to the previous
+     * device is invalidated.
      * @param[in] rom code.
      */
     void rom(const uint8_t* rom)
@@ -309,10 +631,12 @@ public:
 	crc = OWI::crc_update(crc, data);
       }
       m_rom[ROM_MAX - 1] = crc;
+      invalidate();
     }
 
     /**
-     * Set device rom code.
+     * Set device rom code. Driver state that belongs to the previous
+     * device is invalidated.
      * @param[in] rom code in program memory.
      */
     void rom_P(const uint8_t* rom)
@@ -324,6 +648,37 @@ public:
 	crc = OWI::crc_update(crc, data);
       }
       m_rom[ROM_MAX - 1] = crc;
+      invalidate();
+    }
+
+    /**
+     * Set device rom code from given table entry. Allows a single
+     * device driver instance to be used for several devices. Driver
+     * state that belongs to the previous device is invalidated.
+     * Returns false(0) if the handle is out of range; the rom code
+     * is not changed.
+     * @param[in] table device rom code table.
+     * @param[in] handle device table index.
+     * @return true(1) if successful otherwise false(0).
+     */
+    bool rom(const Table& table, uint8_t handle)
+    {
+      if (handle >= table.count()) return (false);
+      table.rom(handle, m_rom);
+      invalidate();
+      return (true);
+    }
+
+    /**
+     * Invalidate driver state that belongs to the device, e.g. caches
+     * and shadows. The driver drops the state before next use, see
+     * invalidated(). Called when the rom code is set with rom() or
+     * rom_P(). Should be called when the rom code is changed through
+     * the rom() buffer, e.g. by search_rom().
+     */
+    void invalidate()
+    {
+      m_invalidated = true;
     }
 
     /**
@@ -341,20 +696,167 @@ public:
 
     /** Device rom idenity code. */
     uint8_t m_rom[ROM_MAX];
+
+    /** Driver state invalidated; see invalidate(). */
+    bool m_invalidated;
+
+    /**
+     * Check and clear driver state invalidated flag. Drivers with
+     * state that belongs to the device drop the state when true(1)
+     * before using it.
+     * @return true(1) if invalidated otherwise false(0).
+     */
+    bool invalidated()
+    {
+      bool res = m_invalidated;
+      m_invalidated = false;
+      return (res);
+    }
   };
 
-protected:
-  /** Maximum number of reset retries. */
-  static const uint8_t RESET_RETRY_MAX = 4;
+  /**
+   * Search statistics; rejected rom codes (check sum error or zero
+   * family code), rom searches where no device answered (e.g. device
+   * removed during search), and searches that failed after retry.
+   */
+  struct search_stats_t {
+    uint16_t errors;		//!< Number of rejected rom codes.
+    uint16_t empty;		//!< Number of searches without answer.
+    uint16_t failures;		//!< Number of failed searches.
+  };
 
   /**
+   * Get search statistics.
+   * @return statistics.
+   */
+  const search_stats_t& search_stats() const
+  {
+    return (m_search_stats);
+  }
+
+  /**
+   * Clear search statistics.
+   */
+  void search_stats_clear()
+  {
+    m_search_stats.errors = 0;
+    m_search_stats.empty = 0;
+    m_search_stats.failures = 0;
+  }
+
+  /**
+   * Transaction line time cost model (us) for the given bus manager
+   * timing profile; RESET_TIME, BIT_TIME, READ_TIME, WRITE_TIME and
+   * TRIPLET_TIME, e.g. Software::OWI and Hardware::OWI. All functions
+   * are constexpr and may be used in static_assert() to check that a
+   * polling plan fits the period.
+   * @param[in] BUS bus manager class.
+   */
+  template<typename BUS>
+  class Cost {
+  public:
+    /** Reset and presence. */
+    static constexpr uint32_t reset()
+    {
+      return (BUS::RESET_TIME);
+    }
+
+    /** Read given number of bytes. */
+    static constexpr uint32_t read(uint32_t count)
+    {
+      return (count * BUS::READ_TIME);
+    }
+
+    /** Write given number of bytes. */
+    static constexpr uint32_t write(uint32_t count)
+    {
+      return (count * BUS::WRITE_TIME);
+    }
+
+    /** Read or write given number of bits. */
+    static constexpr uint32_t bits(uint32_t count)
+    {
+      return (count * BUS::BIT_TIME);
+    }
+
+    /** Skip rom; reset and command. */
+    static constexpr uint32_t skip_rom()
+    {
+      return (reset() + write(1));
+    }
+
+    /** Resume; reset and command. */
+    static constexpr uint32_t resume()
+    {
+      return (reset() + write(1));
+    }
+
+    /** Match rom; reset, command and rom code. */
+    static constexpr uint32_t match_rom()
+    {
+      return (reset() + write(1 + ROM_MAX));
+    }
+
+    /** Search for one device; reset, command and rom triplets. */
+    static constexpr uint32_t search()
+    {
+      return (reset() + write(1) + ROMBITS * BUS::TRIPLET_TIME);
+    }
+
+    /** Search for given number of devices. */
+    static constexpr uint32_t search(uint32_t devices)
+    {
+      return (devices * search());
+    }
+
+    /**
+     * Device function; match rom (or skip rom), and given number of
+     * bytes to write and read.
+     */
+    static constexpr uint32_t function(uint32_t wr, uint32_t rd,
+				       bool match = true)
+    {
+      return ((match ? match_rom() : skip_rom()) + write(wr) + read(rd));
+    }
+  };
+
+  /**
+   * @override{OWI}
+   * Exchange given number of bytes; block step of transfer(), and
+   * of read() and write() of buffers. Writes bytes from source
+   * buffer, or reads when null, and stores bytes read in destination
+   * buffer, if not null. Bytes are read and discarded when both are
+   * null. Returns false(0) if the transfer failed. Bus managers may
+   * override to keep several bytes in flight. The default writes or
+   * reads byte by byte; the destination is only stored when reading.
+   * @param[in] src source buffer (or null).
+   * @param[in] dst destination buffer (or null).
+   * @param[in] count number of bytes.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool exchange(const uint8_t* src, uint8_t* dst, size_t count)
+  {
+    while (count--) {
+      if (src != NULL) {
+	write(*src++);
+	continue;
+      }
+      uint8_t value = read();
+      if (dst != NULL) *dst++ = value;
+    }
+    return (true);
+  }
+
+  /**
+   * @override{OWI}
    * Search device rom given the last position of discrepancy and
-   * partial or full rom code.
+   * partial or full rom code. Bus managers with search support
+   * may override to perform the search pass in one exchange.
    * @param[in] code device identity rom.
    * @param[in] last position of discrepancy (default FIRST).
    * @return position of difference or negative error code.
    */
-  int8_t search(uint8_t* code, int8_t last = FIRST)
+  virtual int8_t search(uint8_t* code, int8_t last = FIRST)
   {
     uint8_t pos = 0;
     int8_t next = LAST;
@@ -380,5 +882,120 @@ protected:
     }
     return (next);
   }
+
+protected:
+  /** Maximum number of reset retries. */
+  static const uint8_t RESET_RETRY_MAX = 4;
+
+  /** Initial and maximum reset backoff period in milli-seconds. */
+  static const uint16_t BACKOFF_MIN = 4;
+  static const uint16_t BACKOFF_MAX = 1024;
+
+  /** Bus state; result of latest reset. */
+  int8_t m_bus_state;
+
+#if OWI_BACKOFF
+  /** Reset backoff period in milli-seconds. */
+  uint16_t m_backoff;
+
+  /** Reset backoff start in milli-seconds. */
+  uint16_t m_backoff_start;
+#endif
+
+  /**
+   * Check if reset should be skipped; the bus was empty or shorted
+   * and the backoff period has not expired. Used by reset()
+   * implementations to fail fast.
+   * @return true(1) if reset should be skipped otherwise false(0).
+   */
+  bool backoff()
+  {
+#if OWI_BACKOFF
+    if (m_backoff == 0) return (false);
+    return ((uint16_t) (((uint16_t) millis()) - m_backoff_start) < m_backoff);
+#else
+    return (false);
+#endif
+  }
+
+  /**
+   * Set bus state after reset. The backoff period is doubled while
+   * the bus is empty or shorted, and cleared on presence. An adapter
+   * failure does not change the backoff period.
+   * @param[in] state bus state.
+   */
+  void bus_state(int8_t state)
+  {
+    m_bus_state = state;
+#if OWI_BACKOFF
+    if (state == BUS_ERROR) return;
+    if (state == BUS_PRESENT || state == BUS_GLITCH) {
+      m_backoff = 0;
+      return;
+    }
+    if (m_backoff == 0)
+      m_backoff = BACKOFF_MIN;
+    else if (m_backoff < BACKOFF_MAX)
+      m_backoff <<= 1;
+    m_backoff_start = millis();
+#endif
+  }
+
+  /** Maximum number of branch retries on rom check sum error. */
+  static const uint8_t SEARCH_RETRY_MAX = 2;
+
+  /** Search statistics. */
+  search_stats_t m_search_stats;
+
+  /**
+   * Update transaction check sum with given value according to
+   * segment check sum mode.
+   * @param[in] op segment operation and mode.
+   * @param[in] crc check sum.
+   * @param[in] value to append.
+   * @return crc.
+   */
+  static uint16_t tx_update(uint8_t op, uint16_t crc, uint8_t value)
+  {
+    if (op & TX_CRC16) return (crc16_update(crc, value));
+    if (op & TX_CRC8) return (crc_update(crc, value));
+    return (crc);
+  }
+
+  /**
+   * Issue given search command (rom or alarm) and search device rom
+   * given the last position of discrepancy. The check sum of the rom
+   * code is verified and a zero family code (bus held low) is
+   * rejected. On error, or when no device answers a rom search, the
+   * same branch is searched again from the given last position of
+   * discrepancy instead of restarting the enumeration. The given rom
+   * code is only updated when successful.
+   * @param[in] cmd search command.
+   * @param[in,out] code device identity rom.
+   * @param[in] last position of discrepancy.
+   * @return position of difference or negative error code.
+   */
+  int8_t search(uint8_t cmd, uint8_t* code, int8_t last)
+  {
+    uint8_t retry = SEARCH_RETRY_MAX;
+    uint8_t rom[ROM_MAX];
+    int8_t res;
+    while (1) {
+      if (!reset()) return (ERROR);
+      write(cmd);
+      memcpy(rom, code, sizeof(rom));
+      res = search(rom, last);
+      if (res != ERROR && rom[0] != 0 && crc(rom, sizeof(rom)) == 0) break;
+      if (res != ERROR) m_search_stats.errors += 1;
+      else if (cmd == SEARCH_ROM) m_search_stats.empty += 1;
+      else return (ERROR);
+      if (retry-- == 0) {
+	m_search_stats.failures += 1;
+	return (ERROR);
+      }
+    }
+    memcpy(code, rom, sizeof(rom));
+    return (res);
+  }
 };
 #endif
@@ -0,0 +1,207 @@
+/**
+ * @file Sample/Decoder.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SAMPLE_DECODER_H
+#define SAMPLE_DECODER_H
+
+#include <string.h>
+#include "Sample/Frame.h"
+
+/**
+ * Binary sample stream decoder. Bytes are given one at a time; the
+ * decoder returns the frame type when a frame with valid check sum
+ * has been received. The rom code dictionary is kept by the decoder
+ * (256 entries), and sample time stamps are accumulated from the
+ * deltas. On a check sum error the decoder synchronizes on the next
+ * frame type in the received bytes. Intended for host programs; has
+ * no Arduino dependencies.
+ */
+namespace Sample {
+class Decoder {
+public:
+  /**
+   * Construct decoder with empty dictionary.
+   */
+  Decoder() :
+    m_count(0),
+    m_index(0),
+    m_value(0),
+    m_timestamp(0),
+    m_errors(0)
+  {
+    memset(m_valid, 0, sizeof(m_valid));
+  }
+
+  /**
+   * Decode given byte. Return frame type (DICTIONARY or SAMPLE) when
+   * a valid frame has been received, otherwise zero. After a check
+   * sum error the frame type is that of the last valid frame found
+   * in the buffered bytes.
+   * @param[in] c byte to decode.
+   * @return frame type or zero.
+   */
+  int put(uint8_t c)
+  {
+    // Synchronize on frame type
+    if (m_count == 0 && c != DICTIONARY && c != SAMPLE) {
+      m_errors += 1;
+      return (0);
+    }
+    m_frame[m_count++] = c;
+
+    // Check for complete frame
+    int size = length();
+    if (size == 0) return (0);
+    if (size < 0) return (resync());
+    if (m_count < size) return (0);
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < m_count; i++) crc = crc_update(crc, m_frame[i]);
+    if (crc != 0) return (resync());
+
+    // Decode frame
+    uint8_t type = m_frame[0];
+    m_index = m_frame[1];
+    m_count = 0;
+    if (type == DICTIONARY) {
+      memcpy(m_rom[m_index], &m_frame[2], ROM_MAX);
+      m_valid[m_index / 8] |= (1 << (m_index % 8));
+      m_timestamp = 0;
+      return (DICTIONARY);
+    }
+    uint32_t delta = 0;
+    uint8_t i = 2;
+    uint8_t shift = 0;
+    do {
+      delta |= (uint32_t) (m_frame[i] & 0x7f) << shift;
+      shift += 7;
+    } while (m_frame[i++] & 0x80);
+    m_timestamp += delta;
+    m_value = m_frame[i] | (m_frame[i + 1] << 8);
+    return (SAMPLE);
+  }
+
+  /**
+   * Get device index of latest frame.
+   * @return index.
+   */
+  uint8_t index() const
+  {
+    return (m_index);
+  }
+
+  /**
+   * Get rom code for given device index, or NULL if not in the
+   * dictionary.
+   * @param[in] index device index.
+   * @return rom code or NULL.
+   */
+  const uint8_t* rom(uint8_t index) const
+  {
+    if ((m_valid[index / 8] & (1 << (index % 8))) == 0) return (NULL);
+    return (m_rom[index]);
+  }
+
+  /**
+   * Get value of latest sample.
+   * @return raw device reading.
+   */
+  int16_t value() const
+  {
+    return (m_value);
+  }
+
+  /**
+   * Get time stamp of latest sample.
+   * @return time stamp in milli-seconds.
+   */
+  uint32_t timestamp() const
+  {
+    return (m_timestamp);
+  }
+
+  /**
+   * Get number of bytes skipped during synchronization.
+   * @return errors.
+   */
+  uint32_t errors() const
+  {
+    return (m_errors);
+  }
+
+protected:
+  /** Frame buffer. */
+  uint8_t m_frame[FRAME_MAX];
+
+  /** Number of bytes in frame buffer. */
+  uint8_t m_count;
+
+  /** Device index of latest frame. */
+  uint8_t m_index;
+
+  /** Value of latest sample. */
+  int16_t m_value;
+
+  /** Time stamp of latest sample. */
+  uint32_t m_timestamp;
+
+  /** Number of skipped bytes. */
+  uint32_t m_errors;
+
+  /** Dictionary rom codes. */
+  uint8_t m_rom[256][ROM_MAX];
+
+  /** Dictionary valid entries. */
+  uint8_t m_valid[256 / 8];
+
+  /**
+   * Get length of frame in buffer; zero if not yet known, negative
+   * if the frame is invalid, i.e. more than DELTA_MAX delta bytes.
+   * @return length, zero or negative error code.
+   */
+  int length() const
+  {
+    if (m_frame[0] == DICTIONARY) return (FRAME_MAX);
+    for (uint8_t i = 2; i < m_count && i < 2 + DELTA_MAX; i++)
+      if ((m_frame[i] & 0x80) == 0) return (i + 4);
+    if (m_count > 2 + DELTA_MAX) return (-1);
+    return (0);
+  }
+
+  /**
+   * Drop the frame type and decode the remaining bytes in the buffer
+   * to synchronize on the next frame. Returns type of the last valid
+   * frame found, otherwise zero.
+   * @return frame type or zero.
+   */
+  int resync()
+  {
+    uint8_t buf[FRAME_MAX];
+    uint8_t count = m_count - 1;
+    memcpy(buf, &m_frame[1], count);
+    m_count = 0;
+    m_errors += 1;
+    int res = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      int type = put(buf[i]);
+      if (type != 0) res = type;
+    }
+    return (res);
+  }
+};
+};
+#endif
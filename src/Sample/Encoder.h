@@ -0,0 +1,110 @@
+/**
+ * @file Sample/Encoder.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SAMPLE_ENCODER_H
+#define SAMPLE_ENCODER_H
+
+#include "Sample/Frame.h"
+
+/**
+ * Binary sample stream encoder. Frames are built in a small buffer
+ * and written to the output stream with a single write. See
+ * Sample/Frame.h for the frame format and Sample::Decoder.
+ */
+namespace Sample {
+class Encoder {
+public:
+  /**
+   * Construct encoder for given output stream.
+   * @param[in] out output stream.
+   */
+  Encoder(Print& out) :
+    m_out(out),
+    m_timestamp(0)
+  {
+  }
+
+  /**
+   * Write dictionary frame with given device index and rom code. The
+   * time stamp reference is reset; the next sample delta is the time
+   * stamp.
+   * @param[in] index device index.
+   * @param[in] rom device rom code.
+   * @return number of bytes written.
+   */
+  size_t rom(uint8_t index, const uint8_t* rom)
+  {
+    uint8_t frame[FRAME_MAX];
+    uint8_t n = 0;
+    m_timestamp = 0;
+    frame[n++] = DICTIONARY;
+    frame[n++] = index;
+    for (uint8_t i = 0; i < ROM_MAX; i++) frame[n++] = rom[i];
+    return (write(frame, n));
+  }
+
+  /**
+   * Write sample frame with given device index, value and time
+   * stamp. The time stamp is sent as the delta since the previous
+   * sample.
+   * @param[in] index device index.
+   * @param[in] value raw device reading.
+   * @param[in] timestamp time stamp in milli-seconds.
+   * @return number of bytes written.
+   */
+  size_t sample(uint8_t index, int16_t value, uint32_t timestamp)
+  {
+    uint8_t frame[FRAME_MAX];
+    uint8_t n = 0;
+    uint32_t delta = timestamp - m_timestamp;
+    m_timestamp = timestamp;
+    frame[n++] = SAMPLE;
+    frame[n++] = index;
+    while (delta >= 0x80) {
+      frame[n++] = (delta & 0x7f) | 0x80;
+      delta >>= 7;
+    }
+    frame[n++] = delta;
+    frame[n++] = value;
+    frame[n++] = value >> 8;
+    return (write(frame, n));
+  }
+
+protected:
+  /** Output stream. */
+  Print& m_out;
+
+  /** Time stamp of the previous sample. */
+  uint32_t m_timestamp;
+
+  /**
+   * Append check sum to given frame and write to the output stream.
+   * @param[in] frame buffer (FRAME_MAX bytes).
+   * @param[in] count number of bytes in frame.
+   * @return number of bytes written.
+   */
+  size_t write(uint8_t* frame, uint8_t count)
+  {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < count; i++) crc = crc_update(crc, frame[i]);
+    frame[count++] = crc;
+    return (m_out.write(frame, count));
+  }
+};
+};
+#endif
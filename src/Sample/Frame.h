@@ -0,0 +1,80 @@
+/**
+ * @file Sample/Frame.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SAMPLE_FRAME_H
+#define SAMPLE_FRAME_H
+
+#include <stdint.h>
+
+/**
+ * Binary sample stream frame format. Device rom codes are sent once
+ * in dictionary frames, and samples refer to the device by index.
+ * All frames start with the frame type and end with a CRC8 of the
+ * frame. Multi-byte values are little-endian.
+ * @code
+ * DICTIONARY: type, index, rom[8], crc8
+ * SAMPLE:     type, index, delta[1..5], value[2], crc8
+ * @endcode
+ * The sample delta is the time in milli-seconds since the previous
+ * sample, or the time stamp for the first sample after a dictionary
+ * frame. A decoder may start at any dictionary frame. A lost sample
+ * frame offsets the following time stamps until the next dictionary
+ * frame; the dictionary should be resent periodically, and for an
+ * index as soon as it refers to another rom code. The delta is
+ * encoded as a variable length integer; seven bits per byte,
+ * least significant first, and the most significant bit set when
+ * more bytes follow. The value is the raw device reading (int16_t).
+ * This header has no Arduino dependencies and may be used by host
+ * decoders.
+ */
+namespace Sample {
+  /** Frame types. */
+  enum {
+    DICTIONARY = 0xD1,		//!< Device index and rom code.
+    SAMPLE = 0x5A		//!< Device index, delta time and value.
+  };
+
+  /** Size of rom code in dictionary frame. */
+  static const uint8_t ROM_MAX = 8;
+
+  /** Max number of bytes in delta time. */
+  static const uint8_t DELTA_MAX = 5;
+
+  /** Max number of bytes in frame. */
+  static const uint8_t FRAME_MAX = 1 + 1 + ROM_MAX + 1;
+
+  /**
+   * Dallas/Maxim 8-bit Cyclic Redundancy Check, as OWI::crc_update().
+   * Polynomial: x^8 + x^5 + x^4 + 1 (0x8C).
+   * @param[in] crc cyclic redundancy check sum.
+   * @param[in] data to append.
+   * @return crc.
+   */
+  inline uint8_t crc_update(uint8_t crc, uint8_t data)
+  {
+    crc = crc ^ data;
+    for (uint8_t i = 0; i < 8; i++) {
+      if (crc & 0x01)
+	crc = (crc >> 1) ^ 0x8C;
+      else
+	crc >>= 1;
+    }
+    return (crc);
+  }
+};
+#endif
@@ -0,0 +1,189 @@
+/**
+ * @file Search/Cursor.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SEARCH_CURSOR_H
+#define SEARCH_CURSOR_H
+
+#include "OWI.h"
+
+/**
+ * One-Wire Interface (OWI) resumable device enumeration. The search
+ * state (last position of discrepancy and partial rom) is kept
+ * between calls so that discovery may be spread over several calls
+ * with a bounded number of devices and line time per call. The
+ * enumeration may be restricted to the devices with a given rom
+ * prefix, e.g. family code.
+ */
+class OWI::Cursor {
+public:
+  /**
+   * Construct enumeration cursor for given bus manager. Call begin()
+   * to start an enumeration.
+   * @param[in] owi bus manager.
+   */
+  Cursor(OWI& owi) :
+    m_owi(owi),
+    m_last(FIRST),
+    m_bits(0),
+    m_cmd(SEARCH_ROM),
+    m_done(true)
+  {
+    memset(m_rom, 0, sizeof(m_rom));
+  }
+
+  /**
+   * Start enumeration of devices with given family code, or all
+   * devices if zero(0). Enumerate only alarming devices if the alarm
+   * flag is set.
+   * @param[in] family code (default all).
+   * @param[in] alarm search (default false).
+   */
+  void begin(uint8_t family = 0, bool alarm = false)
+  {
+    begin(&family, family != 0 ? CHARBITS : 0, alarm);
+  }
+
+  /**
+   * Start enumeration of devices with given rom prefix. The prefix
+   * is given number of bits (LSB first) from the start of the rom,
+   * i.e. family code is the first 8-bits. The search starts at the
+   * prefix and stops when the prefix sub-tree is completed.
+   * @param[in] prefix rom code prefix.
+   * @param[in] bits number of prefix bits (0..ROMBITS).
+   * @param[in] alarm search (default false).
+   */
+  void begin(const uint8_t* prefix, uint8_t bits, bool alarm = false)
+  {
+    if (bits > ROMBITS) bits = ROMBITS;
+    memset(m_rom, 0, sizeof(m_rom));
+    memcpy(m_rom, prefix, (bits + CHARBITS - 1) / CHARBITS);
+    if (bits & (CHARBITS - 1))
+      m_rom[bits / CHARBITS] &= (1 << (bits & (CHARBITS - 1))) - 1;
+    m_bits = bits;
+    m_last = (bits == 0) ? FIRST : LAST;
+    m_cmd = alarm ? ALARM_SEARCH : SEARCH_ROM;
+    m_done = false;
+  }
+
+  /**
+   * Search next device in enumeration. Returns true(1) and rom code
+   * in given buffer if found, otherwise false(0); enumeration
+   * completed or error, see done().
+   * @param[out] code device identity.
+   * @return true(1) if found otherwise false(0).
+   */
+  bool next(uint8_t* code)
+  {
+    return (next((uint8_t (*)[ROM_MAX]) code, 1) == 1);
+  }
+
+  /**
+   * Continue enumeration and store at most given number of rom
+   * codes in buffer. Returns when the maximum number of devices have
+   * been found, the enumeration is completed, or another search
+   * would exceed the given line time budget (us). At least one
+   * search is issued per call. Returns number of devices found or
+   * negative error code. The enumeration may be continued after an
+   * error.
+   * @param[out] code buffer for device identities.
+   * @param[in] max number of devices.
+   * @param[in] us line time budget (default 0, no limit).
+   * @return number of devices or negative error code.
+   */
+  int8_t next(uint8_t (*code)[ROM_MAX], uint8_t max, uint16_t us = 0)
+  {
+    uint32_t start = micros();
+    uint16_t pass = 0;
+    int8_t count = 0;
+    while (!m_done && count < max) {
+      if (us != 0 && count != 0 && (micros() - start) + pass > us) break;
+      uint32_t stamp = micros();
+      uint8_t rom[ROM_MAX];
+      memcpy(rom, m_rom, sizeof(rom));
+      int8_t last = m_owi.search(m_cmd, rom, m_last);
+      if (last == ERROR) {
+	if (count == 0) return (ERROR);
+	break;
+      }
+      pass = micros() - stamp;
+      if (!match(rom)) {
+	m_done = true;
+	break;
+      }
+      memcpy(m_rom, rom, sizeof(rom));
+      memcpy(code[count++], rom, sizeof(rom));
+      m_last = last;
+      m_done = (last == LAST) || (last < m_bits);
+    }
+    return (count);
+  }
+
+  /**
+   * Return true(1) if the enumeration is completed otherwise false(0).
+   * @return bool.
+   */
+  bool done() const
+  {
+    return (m_done);
+  }
+
+  /**
+   * Return last position of discrepancy; the search state.
+   * @return position.
+   */
+  int8_t last() const
+  {
+    return (m_last);
+  }
+
+protected:
+  /** One-Wire Bus Manager. */
+  OWI& m_owi;
+
+  /** Partial rom code; prefix or latest device found. */
+  uint8_t m_rom[ROM_MAX];
+
+  /** Last position of discrepancy. */
+  int8_t m_last;
+
+  /** Number of prefix bits. */
+  uint8_t m_bits;
+
+  /** Search command; rom or alarm search. */
+  uint8_t m_cmd;
+
+  /** Enumeration completed. */
+  bool m_done;
+
+  /**
+   * Return true(1) if the given rom code matches the prefix,
+   * otherwise false(0).
+   * @param[in] code device identity.
+   * @return bool.
+   */
+  bool match(const uint8_t* code) const
+  {
+    uint8_t i = 0;
+    uint8_t bits = m_bits;
+    for (; bits >= CHARBITS; bits -= CHARBITS, i++)
+      if (code[i] != m_rom[i]) return (false);
+    if (bits == 0) return (true);
+    return (((code[i] ^ m_rom[i]) & ((1 << bits) - 1)) == 0);
+  }
+};
+#endif
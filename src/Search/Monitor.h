@@ -0,0 +1,263 @@
+/**
+ * @file Search/Monitor.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SEARCH_MONITOR_H
+#define SEARCH_MONITOR_H
+
+#include "OWI.h"
+#include "Search/Cursor.h"
+
+/**
+ * One-Wire Interface (OWI) device change monitor. Keeps the known
+ * device set in a table sorted in search order, i.e. the leaves of
+ * the binary rom prefix tree, and merges it with an incremental
+ * enumeration of the bus. Arrivals and departures are reported as
+ * events; override on_arrival() and on_departure(). The enumeration
+ * may be spread over several calls to poll() with a bounded number
+ * of search passes and line time per call.
+ *
+ * A round costs one search pass per present device (matching the
+ * family code), and no passes for departed devices. It is not
+ * proportional to the changed branches only; a search pass observes
+ * the branch points on its path, and a device that arrives below
+ * the last branch point of a known device is only seen by the pass
+ * to that device. An empty bus is detected with a single reset.
+ * Devices that do not fit in the table are not reported, see
+ * overflow().
+ */
+class OWI::Monitor {
+public:
+  /**
+   * Construct device monitor for given bus manager, known device
+   * table and family code (default all).
+   * @param[in] owi bus manager.
+   * @param[in] table device rom code table.
+   * @param[in] max number of table entries.
+   * @param[in] family code (default 0, all).
+   */
+  Monitor(OWI& owi, uint8_t (*table)[ROM_MAX], uint8_t max,
+	  uint8_t family = 0) :
+    m_owi(owi),
+    m_cursor(owi),
+    m_table(table),
+    m_max(max),
+    m_count(0),
+    m_index(0),
+    m_family(family),
+    m_overflow(false)
+  {
+  }
+
+  /**
+   * Return number of known devices.
+   * @return count.
+   */
+  uint8_t count() const
+  {
+    return (m_count);
+  }
+
+  /**
+   * Return rom code of known device with given index.
+   * @param[in] ix table index.
+   * @return rom code.
+   */
+  const uint8_t* rom(uint8_t ix) const
+  {
+    return (m_table[ix]);
+  }
+
+  /**
+   * Continue change detection with at most given number of search
+   * passes and line time budget (us). A new round is started when
+   * the previous is completed. Returns number of reported changes
+   * or negative error code. The round is restarted on error. A bus
+   * adapter failure (BUS_ERROR) is an error; known devices are only
+   * reported as departed on an empty or shorted bus.
+   * @param[in] max number of search passes (default 8).
+   * @param[in] us line time budget (default 0, no limit).
+   * @return number of changes or negative error code.
+   */
+  int8_t poll(uint8_t max = 8, uint16_t us = 0)
+  {
+    uint32_t start = micros();
+    int8_t changes = 0;
+
+    // Start new round. Empty bus; all known devices departed
+    if (m_cursor.done()) {
+      if (!m_owi.reset()) {
+	if (m_owi.bus_state() == BUS_ERROR) return (ERROR);
+	m_overflow = false;
+	while (m_count != 0) changes += remove(m_count - 1);
+	return (changes);
+      }
+      m_cursor.begin(m_family);
+      m_index = 0;
+      m_overflow = false;
+    }
+
+    // Merge bus enumeration with known devices
+    while (max--) {
+      uint8_t rom[ROM_MAX];
+      if (us != 0 && micros() - start > us) break;
+      int8_t res = m_cursor.next((uint8_t (*)[ROM_MAX]) rom, 1);
+      if (res == ERROR) {
+	m_cursor.begin(m_family);
+	m_index = 0;
+	return (ERROR);
+      }
+      if (res == 0) break;
+      while (m_index < m_count && order(m_table[m_index], rom) < 0)
+	changes += remove(m_index);
+      if (m_index < m_count && order(m_table[m_index], rom) == 0)
+	m_index += 1;
+      else
+	changes += insert(m_index, rom);
+      if (m_cursor.done()) break;
+    }
+
+    // End of round; remaining known devices departed
+    if (m_cursor.done()) {
+      while (m_count > m_index) changes += remove(m_count - 1);
+    }
+    return (changes);
+  }
+
+  /**
+   * Return true(1) if the latest round is completed, otherwise
+   * false(0).
+   * @return bool.
+   */
+  bool done() const
+  {
+    return (m_cursor.done());
+  }
+
+  /**
+   * Return true(1) if devices were found in the latest round that
+   * did not fit in the table, otherwise false(0). These devices are
+   * not reported as arrivals until there is room in the table.
+   * @return bool.
+   */
+  bool overflow() const
+  {
+    return (m_overflow);
+  }
+
+  /**
+   * Compare given rom codes in search order; the first bit that
+   * differs (LSB first) decides. Returns negative, zero or positive
+   * value.
+   * @param[in] a device identity.
+   * @param[in] b device identity.
+   * @return order.
+   */
+  static int8_t order(const uint8_t* a, const uint8_t* b)
+  {
+    for (uint8_t i = 0; i < ROM_MAX; i++) {
+      uint8_t diff = a[i] ^ b[i];
+      if (diff == 0) continue;
+      return ((a[i] & diff & -diff) ? 1 : -1);
+    }
+    return (0);
+  }
+
+protected:
+  /**
+   * @override{OWI::Monitor}
+   * Called when a device has been detected that is not in the
+   * table, and has been added to the table.
+   * @param[in] rom device identity.
+   */
+  virtual void on_arrival(const uint8_t* rom)
+  {
+    (void) rom;
+  }
+
+  /**
+   * @override{OWI::Monitor}
+   * Called when a known device was not detected. The device is
+   * removed from the table after the call.
+   * @param[in] rom device identity.
+   */
+  virtual void on_departure(const uint8_t* rom)
+  {
+    (void) rom;
+  }
+
+  /** One-Wire Bus Manager. */
+  OWI& m_owi;
+
+  /** Bus enumeration state. */
+  Cursor m_cursor;
+
+  /** Known devices in search order. */
+  uint8_t (*m_table)[ROM_MAX];
+
+  /** Max number of known devices. */
+  uint8_t m_max;
+
+  /** Number of known devices. */
+  uint8_t m_count;
+
+  /** Next known device to merge in current round. */
+  uint8_t m_index;
+
+  /** Family code filter. */
+  uint8_t m_family;
+
+  /** Devices found in the current round that did not fit. */
+  bool m_overflow;
+
+  /**
+   * Insert given device rom at given table index and report
+   * arrival. Returns number of changes (1), or zero(0) and marks
+   * overflow if the table is full.
+   * @param[in] ix table index.
+   * @param[in] rom device identity.
+   * @return changes.
+   */
+  int8_t insert(uint8_t ix, const uint8_t* rom)
+  {
+    if (m_count == m_max) {
+      m_overflow = true;
+      return (0);
+    }
+    memmove(m_table[ix + 1], m_table[ix], (m_count - ix) * ROM_MAX);
+    memcpy(m_table[ix], rom, ROM_MAX);
+    m_count += 1;
+    m_index += 1;
+    on_arrival(rom);
+    return (1);
+  }
+
+  /**
+   * Report departure and remove device at given table index.
+   * Returns number of changes (1).
+   * @param[in] ix table index.
+   * @return changes.
+   */
+  int8_t remove(uint8_t ix)
+  {
+    on_departure(m_table[ix]);
+    m_count -= 1;
+    memmove(m_table[ix], m_table[ix + 1], (m_count - ix) * ROM_MAX);
+    return (1);
+  }
+};
+#endif
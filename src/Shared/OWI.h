@@ -0,0 +1,454 @@
+/**
+ * @file Shared/OWI.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SHARED_OWI_H
+#define SHARED_OWI_H
+
+#include "OWI.h"
+
+/**
+ * Wait hook for the critical section spin lock and the ownership
+ * wait on other targets than AVR. Defaults to yield(). On a
+ * preemptive RTOS a waiting higher priority task must block so that
+ * the lower priority owner may run; define before including the
+ * library, e.g. as vTaskDelay(1) on FreeRTOS.
+ */
+#ifndef OWI_SHARED_YIELD
+#define OWI_SHARED_YIELD() yield()
+#endif
+
+/**
+ * One Wire Interface (OWI) Bus Manager class for a bus shared by
+ * several tasks, e.g. threads on an RTOS or a host. Transactions are
+ * made atomic with bus ownership; acquire() and release() or a Guard,
+ * with priority-aware waiting. Transactions may also be posted to a
+ * queue that is executed in batches by a dedicated bus task with
+ * dispatch(). Bus access is forwarded to the given bus manager.
+ *
+ * The ownership and queue state is protected by a critical section;
+ * interrupts are disabled and the interrupt state is restored on AVR,
+ * elsewhere an atomic spin lock is used so that several cores and
+ * host threads may share the bus; waiting tasks call the
+ * OWI_SHARED_YIELD() hook. On AVR post() may be called from
+ * interrupt handlers, elsewhere only from tasks.
+ *
+ * Ownership is not reentrant; a task that owns the bus must access
+ * it directly and not call acquire() or dispatch() as these will
+ * wait forever. Use try_acquire() where the caller may own the bus.
+ */
+namespace Shared {
+class OWI : public ::OWI {
+public:
+  /** Number of bus ownership priority levels. */
+  static const uint8_t PRIO_MAX = 4;
+
+  /**
+   * Construct shared bus manager on given bus manager.
+   * @param[in] owi bus manager.
+   */
+  OWI(::OWI& owi) :
+    m_owi(owi),
+    m_lock(false),
+    m_owned(false),
+    m_tx_head(NULL),
+    m_tx_tail(NULL)
+  {
+    for (uint8_t prio = 0; prio < PRIO_MAX; prio++) {
+      m_ticket[prio] = 0;
+      m_serving[prio] = 0;
+    }
+  }
+
+  /**
+   * @override{OWI}
+   * Reset the one wire bus and check that at least one device is
+   * presence.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool reset()
+  {
+    bool res = m_owi.reset();
+    bus_state(m_owi.bus_state());
+    return (res);
+  }
+
+  /**
+   * @override{OWI}
+   * Read the given number of bits from the one wire bus.
+   * @param[in] bits to be read.
+   * @return value read.
+   */
+  virtual uint8_t read(uint8_t bits = CHARBITS)
+  {
+    return (m_owi.read(bits));
+  }
+
+  /**
+   * @override{OWI}
+   * Write the given value to the one wire bus.
+   * @param[in] value to write.
+   * @param[in] bits to be written.
+   */
+  virtual void write(uint8_t value, uint8_t bits = CHARBITS)
+  {
+    m_owi.write(value, bits);
+  }
+
+  using ::OWI::read;
+  using ::OWI::write;
+  using ::OWI::match_rom;
+
+  /**
+   * @override{OWI}
+   * Execute the given transaction.
+   * @param[in] seg transaction segments.
+   * @param[in] count number of segments.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool transfer(const segment_t* seg, uint8_t count)
+  {
+    return (m_owi.transfer(seg, count));
+  }
+
+  /**
+   * @override{OWI}
+   * Search support function.
+   * @param[in,out] dir bit to write when discrepancy read.
+   * @return 2-bits read and bit written.
+   */
+  virtual int8_t triplet(uint8_t& dir)
+  {
+    return (m_owi.triplet(dir));
+  }
+
+  /**
+   * @override{OWI}
+   * Exchange given number of bytes; forwarded so that bus manager
+   * block pipelining applies, e.g. UART::OWI and UART::DS2480B.
+   * @param[in] src source buffer (or null).
+   * @param[in] dst destination buffer (or null).
+   * @param[in] count number of bytes.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool exchange(const uint8_t* src, uint8_t* dst, size_t count)
+  {
+    return (m_owi.exchange(src, dst, count));
+  }
+
+  /**
+   * @override{OWI}
+   * Search device rom given the last position of discrepancy;
+   * forwarded so that bus manager search support applies, e.g. the
+   * UART::DS2480B search accelerator.
+   * @param[in] code device identity rom.
+   * @param[in] last position of discrepancy (default FIRST).
+   * @return position of difference or negative error code.
+   */
+  virtual int8_t search(uint8_t* code, int8_t last = FIRST)
+  {
+    return (m_owi.search(code, last));
+  }
+
+  /**
+   * @override{OWI}
+   * Match device rom; forwarded so that bus manager overrides apply,
+   * e.g. Coupler::OWI branch selection.
+   * @param[in] code device identity.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool match_rom(uint8_t* code)
+  {
+    return (m_owi.match_rom(code));
+  }
+
+  /**
+   * @override{OWI}
+   * Resume device access; forwarded so that bus manager overrides
+   * apply, e.g. Coupler::OWI branch selection.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool resume()
+  {
+    return (m_owi.resume());
+  }
+
+  /**
+   * Acquire bus ownership for a transaction with given priority
+   * (0..PRIO_MAX-1, highest last). Yields while the bus is owned, or
+   * tasks with higher priority are waiting. Tasks with the same
+   * priority are served in order. Returns false(0) if the priority
+   * is out of range, otherwise true(1) when owned. Must be followed
+   * by release(). Not reentrant; see above.
+   * @param[in] prio priority (default 0).
+   * @return true(1) if owned otherwise false(0).
+   */
+  bool acquire(uint8_t prio = 0)
+  {
+    if (prio >= PRIO_MAX) return (false);
+    uint8_t key = lock();
+    uint8_t ticket = m_ticket[prio]++;
+    unlock(key);
+    while (!grant(prio, ticket)) OWI_SHARED_YIELD();
+    return (true);
+  }
+
+  /**
+   * Acquire bus ownership with given priority if the bus is free and
+   * no task with the same or higher priority is waiting. Does not
+   * wait.
+   * @param[in] prio priority (default 0).
+   * @return true(1) if owned otherwise false(0).
+   */
+  bool try_acquire(uint8_t prio = 0)
+  {
+    if (prio >= PRIO_MAX) return (false);
+    uint8_t key = lock();
+    bool res = !m_owned && !waiting(prio);
+    if (res) m_owned = true;
+    unlock(key);
+    return (res);
+  }
+
+  /**
+   * Release bus ownership.
+   */
+  void release()
+  {
+    uint8_t key = lock();
+    m_owned = false;
+    unlock(key);
+  }
+
+  /**
+   * Return true(1) if the bus is owned by a task.
+   * @return bool.
+   */
+  bool owned() const
+  {
+    return (m_owned);
+  }
+
+  /**
+   * Bus ownership for the scope of the guard instance; acquire on
+   * construction and release on destruction.
+   */
+  class Guard {
+  public:
+    /**
+     * Acquire given bus manager with given priority.
+     * @param[in] owi bus manager.
+     * @param[in] prio priority (default 0).
+     */
+    Guard(OWI& owi, uint8_t prio = 0) :
+      m_owi(owi),
+      m_owned(owi.acquire(prio))
+    {
+    }
+
+    /**
+     * Release bus manager if owned.
+     */
+    ~Guard()
+    {
+      if (m_owned) m_owi.release();
+    }
+
+    /**
+     * Return true(1) if the bus was acquired, false(0) if the
+     * priority was out of range.
+     * @return bool.
+     */
+    operator bool() const
+    {
+      return (m_owned);
+    }
+
+  protected:
+    /** Shared Bus Manager. */
+    OWI& m_owi;
+
+    /** Bus acquired. */
+    bool m_owned;
+  };
+
+  /**
+   * Queued transaction descriptor. The device is addressed with the
+   * rom code, or skip rom if null, before the transaction segments
+   * are transferred. The status is set on completion.
+   */
+  struct transaction_t {
+    transaction_t* next;	//!< Next transaction in queue.
+    const uint8_t* rom;		//!< Device rom code (or null).
+    const segment_t* seg;	//!< Transaction segments.
+    uint8_t count;		//!< Number of segments.
+    volatile int8_t status;	//!< Transaction status.
+  };
+
+  /**
+   * Transaction status.
+   */
+  enum {
+    TRANSACTION_DONE = 0,	//!< Completed successfully.
+    TRANSACTION_PENDING = 1,	//!< Queued.
+    TRANSACTION_FAILED = -1	//!< No presence or check sum error.
+  } __attribute__((packed));
+
+  /**
+   * Post given transaction to the bus queue. The transaction
+   * descriptor, rom and segments must remain valid until completed.
+   * @param[in] tx transaction descriptor.
+   * @param[in] rom device rom code (or null for skip rom).
+   * @param[in] seg transaction segments.
+   * @param[in] count number of segments.
+   */
+  void post(transaction_t& tx, const uint8_t* rom,
+	    const segment_t* seg, uint8_t count)
+  {
+    tx.next = NULL;
+    tx.rom = rom;
+    tx.seg = seg;
+    tx.count = count;
+    tx.status = TRANSACTION_PENDING;
+    uint8_t key = lock();
+    if (m_tx_tail == NULL)
+      m_tx_head = &tx;
+    else
+      m_tx_tail->next = &tx;
+    m_tx_tail = &tx;
+    unlock(key);
+  }
+
+  /**
+   * Execute queued transactions, at most the given number, with the
+   * bus acquired with the given priority for the batch. Must not be
+   * called by the bus owner; see above. Returns number of
+   * transactions executed.
+   * @param[in] max number of transactions (default 255).
+   * @param[in] prio priority (default 0).
+   * @return number of transactions.
+   */
+  uint8_t dispatch(uint8_t max = 255, uint8_t prio = 0)
+  {
+    uint8_t res = 0;
+    if (m_tx_head == NULL) return (0);
+    Guard guard(*this, prio);
+    if (!guard) return (0);
+    while (res < max) {
+      uint8_t key = lock();
+      transaction_t* tx = m_tx_head;
+      if (tx != NULL) {
+	m_tx_head = tx->next;
+	if (m_tx_head == NULL) m_tx_tail = NULL;
+      }
+      unlock(key);
+      if (tx == NULL) break;
+      bool ok;
+      if (tx->rom != NULL)
+	ok = match_rom((uint8_t*) tx->rom);
+      else
+	ok = skip_rom();
+      if (ok) ok = transfer(tx->seg, tx->count);
+      tx->status = ok ? TRANSACTION_DONE : TRANSACTION_FAILED;
+      res += 1;
+    }
+    return (res);
+  }
+
+protected:
+  /** Shared bus manager. */
+  ::OWI& m_owi;
+
+  /** Critical section spin lock (not AVR). */
+  volatile bool m_lock;
+
+  /** Bus ownership; owned, and tickets taken and served per priority. */
+  volatile bool m_owned;
+  volatile uint8_t m_ticket[PRIO_MAX];
+  volatile uint8_t m_serving[PRIO_MAX];
+
+  /** Transaction queue. */
+  transaction_t* volatile m_tx_head;
+  transaction_t* volatile m_tx_tail;
+
+  /**
+   * Enter critical section. Returns interrupt state to restore with
+   * unlock().
+   * @return key.
+   */
+  uint8_t lock()
+  {
+#if defined(ARDUINO_ARCH_AVR)
+    uint8_t key = SREG;
+    cli();
+    return (key);
+#else
+    while (__atomic_test_and_set(&m_lock, __ATOMIC_ACQUIRE))
+      OWI_SHARED_YIELD();
+    return (0);
+#endif
+  }
+
+  /**
+   * Leave critical section and restore given interrupt state.
+   * @param[in] key from lock().
+   */
+  void unlock(uint8_t key)
+  {
+#if defined(ARDUINO_ARCH_AVR)
+    SREG = key;
+#else
+    (void) key;
+    __atomic_clear(&m_lock, __ATOMIC_RELEASE);
+#endif
+  }
+
+  /**
+   * Check if tasks with priority from given level are waiting for
+   * bus ownership. Called in critical section.
+   * @param[in] prio lowest priority level to check.
+   * @return true(1) if waiting otherwise false(0).
+   */
+  bool waiting(uint8_t prio)
+  {
+    for (; prio < PRIO_MAX; prio++)
+      if (m_ticket[prio] != m_serving[prio]) return (true);
+    return (false);
+  }
+
+  /**
+   * Grant bus ownership to the given ticket with given priority if
+   * the bus is free, the ticket is served next and no task with
+   * higher priority is waiting.
+   * @param[in] prio priority.
+   * @param[in] ticket from acquire().
+   * @return true(1) if owned otherwise false(0).
+   */
+  bool grant(uint8_t prio, uint8_t ticket)
+  {
+    uint8_t key = lock();
+    bool res = !m_owned && ticket == m_serving[prio] && !waiting(prio + 1);
+    if (res) {
+      m_owned = true;
+      m_serving[prio] += 1;
+    }
+    unlock(key);
+    return (res);
+  }
+};
+};
+#endif
@@ -0,0 +1,335 @@
+/**
+ * @file Slave/Device.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SLAVE_DEVICE_H
+#define SLAVE_DEVICE_H
+
+#include "Slave/OWI.h"
+
+#if defined(ARDUINO_ARCH_AVR)
+#include <avr/eeprom.h>
+#endif
+
+/**
+ * One Wire Interface (OWI) Slave Device framework template class.
+ * Function commands are dispatched through a table of function
+ * codes and handlers. Memory regions (SRAM, EEPROM or program
+ * memory) are served by the generic read and write memory commands.
+ * Responses with fixed contents may be prepared with check sum
+ * before the master requests them (Response), so that no check sum
+ * is calculated while the response is written.
+ *
+ * @section Memory Commands
+ * @code
+ * READ_MEMORY:  cmd, region, offset[2], count -> data[count], crc8
+ * WRITE_MEMORY: cmd, region, offset[2], count, data[count], crc8 -> 2b
+ * @endcode
+ * The write memory result is 0b10 if the data was written, otherwise
+ * 0b00 (check sum error, range error, read-only region, or count
+ * larger than BUF_MAX). A read memory outside the region, or with
+ * count larger than BUF_MAX, is ignored. The read memory data is
+ * copied and the check sum calculated before the first time slot.
+ * @param[in] PIN board pin for 1-wire bus.
+ */
+namespace Slave {
+template<BOARD::pin_t PIN>
+class Device {
+public:
+  /** Max number of bytes in read and write memory command. */
+  static const uint8_t BUF_MAX = 32;
+
+  /**
+   * Generic memory function commands. The codes are reserved when
+   * memory regions are given.
+   */
+  enum {
+    READ_MEMORY = 0xF5,		//!< Read memory region.
+    WRITE_MEMORY = 0x5F		//!< Write memory region.
+  } __attribute__((packed));
+
+  /**
+   * Memory region types.
+   */
+  enum {
+    MEMORY_SRAM = 0,		//!< Data memory.
+    MEMORY_EEPROM = 1,		//!< EEPROM (AVR only).
+    MEMORY_PROGMEM = 2		//!< Program memory (read-only).
+  } __attribute__((packed));
+
+  /**
+   * Function command handler. Called with the device and function
+   * command code; the handler reads parameters and writes the
+   * response with the device bus manager, see owi().
+   * @param[in] dev slave device.
+   * @param[in] cmd function command.
+   */
+  typedef void (*function_t)(Device& dev, uint8_t cmd);
+
+  /**
+   * Function command table entry.
+   */
+  struct command_t {
+    uint8_t code;		//!< Function command code.
+    function_t function;	//!< Handler.
+  };
+
+  /**
+   * Memory region; addressed by index in the region table.
+   */
+  struct region_t {
+    uint8_t type;		//!< Memory type.
+    bool writable;		//!< Write memory allowed.
+    uint16_t size;		//!< Size in bytes.
+    void* mem;			//!< Memory address.
+  };
+
+  /**
+   * Prepared response; data and check sum. The check sum is
+   * calculated when the response is set, and the response is sent
+   * with OWI::send() without check sum calculation.
+   * @param[in] N max number of data bytes.
+   */
+  template<uint8_t N>
+  class Response {
+  public:
+    /**
+     * Construct empty response.
+     */
+    Response() :
+      m_count(0)
+    {
+    }
+
+    /**
+     * Set response data and calculate check sum.
+     * @param[in] buf data.
+     * @param[in] count number of bytes (max N).
+     */
+    void set(const void* buf, uint8_t count)
+    {
+      const uint8_t* bp = (const uint8_t*) buf;
+      uint8_t crc = 0;
+      if (count > N) count = N;
+      for (uint8_t i = 0; i < count; i++) {
+	m_buf[i] = bp[i];
+	crc = OWI<PIN>::crc_update(crc, bp[i]);
+      }
+      m_buf[count] = crc;
+      m_count = count + 1;
+    }
+
+    /**
+     * Get response buffer; data and check sum.
+     * @return buffer.
+     */
+    const uint8_t* buf() const
+    {
+      return (m_buf);
+    }
+
+    /**
+     * Get number of bytes in response, including check sum.
+     * @return count.
+     */
+    uint8_t count() const
+    {
+      return (m_count);
+    }
+
+  protected:
+    /** Data and check sum. */
+    uint8_t m_buf[N + 1];
+
+    /** Number of bytes. */
+    uint8_t m_count;
+  };
+
+  /**
+   * Construct slave device framework on given slave bus manager with
+   * function command table and memory region table.
+   * @param[in] owi slave bus manager.
+   * @param[in] command table.
+   * @param[in] commands number of commands.
+   * @param[in] region table (default NULL).
+   * @param[in] regions number of regions (default 0).
+   */
+  Device(OWI<PIN>& owi,
+	 const command_t* command, uint8_t commands,
+	 const region_t* region = NULL, uint8_t regions = 0) :
+    m_owi(owi),
+    m_command(command),
+    m_commands(commands),
+    m_region(region),
+    m_regions(regions)
+  {
+  }
+
+  /**
+   * Get slave bus manager; for parameter read and response write
+   * in handlers.
+   * @return slave bus manager.
+   */
+  OWI<PIN>& owi()
+  {
+    return (m_owi);
+  }
+
+  /**
+   * Send prepared response.
+   * @param[in] res response.
+   */
+  template<uint8_t N>
+  void send(const Response<N>& res)
+  {
+    m_owi.send(res.buf(), res.count());
+  }
+
+  /**
+   * Check for reset and rom command, read function command and
+   * dispatch to handler, or memory command. Returns true(1) if a
+   * command was handled, otherwise false(0).
+   * @return true(1) if handled otherwise false(0).
+   */
+  bool service()
+  {
+    if (!m_owi.rom_command()) return (false);
+    uint8_t cmd = m_owi.read_command();
+    if (cmd == 0 || m_owi.timedout()) return (false);
+    if (m_regions != 0) {
+      if (cmd == READ_MEMORY) return (read_memory());
+      if (cmd == WRITE_MEMORY) return (write_memory());
+    }
+    for (uint8_t i = 0; i < m_commands; i++) {
+      if (m_command[i].code == cmd) {
+	m_command[i].function(*this, cmd);
+	return (true);
+      }
+    }
+    return (false);
+  }
+
+protected:
+  /** Slave bus manager. */
+  OWI<PIN>& m_owi;
+
+  /** Function command table. */
+  const command_t* m_command;
+
+  /** Number of function commands. */
+  uint8_t m_commands;
+
+  /** Memory region table. */
+  const region_t* m_region;
+
+  /** Number of memory regions. */
+  uint8_t m_regions;
+
+  /**
+   * Read memory command parameters; region, offset and count. Return
+   * region or NULL if out of range. EEPROM regions are out of range
+   * on other architectures than AVR.
+   * @param[out] offset in region.
+   * @param[out] count number of bytes.
+   * @return region or NULL.
+   */
+  const region_t* parameters(uint16_t& offset, uint8_t& count)
+  {
+    uint8_t ix = m_owi.read();
+    m_owi.read(&offset, sizeof(offset));
+    count = m_owi.read();
+    if (ix >= m_regions) return (NULL);
+    const region_t* region = &m_region[ix];
+    if (offset > region->size || count > region->size - offset)
+      return (NULL);
+#if !defined(ARDUINO_ARCH_AVR)
+    if (region->type == MEMORY_EEPROM) return (NULL);
+#endif
+    return (region);
+  }
+
+  /**
+   * Handle read memory command; copy data to buffer and calculate
+   * check sum before the first time slot, and send data and check
+   * sum without check sum calculation in the slots.
+   * @return true(1) if handled otherwise false(0).
+   */
+  bool read_memory()
+  {
+    uint16_t offset;
+    uint8_t count;
+    const region_t* region = parameters(offset, count);
+    if (region == NULL || count > BUF_MAX || m_owi.timedout())
+      return (false);
+    uint8_t buf[BUF_MAX + 1];
+    uint8_t* mp = (uint8_t*) region->mem + offset;
+    switch (region->type) {
+    case MEMORY_SRAM:
+      memcpy(buf, mp, count);
+      break;
+#if defined(ARDUINO_ARCH_AVR)
+    case MEMORY_EEPROM:
+      eeprom_read_block(buf, mp, count);
+      break;
+#endif
+    case MEMORY_PROGMEM:
+      memcpy_P(buf, mp, count);
+      break;
+    }
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < count; i++)
+      crc = OWI<PIN>::crc_update(crc, buf[i]);
+    buf[count] = crc;
+    m_owi.send(buf, count + 1);
+    return (!m_owi.timedout());
+  }
+
+  /**
+   * Handle write memory command; read data and check sum, write to
+   * region and write result.
+   * @return true(1) if handled otherwise false(0).
+   */
+  bool write_memory()
+  {
+    uint16_t offset;
+    uint8_t count;
+    const region_t* region = parameters(offset, count);
+    uint8_t buf[BUF_MAX + 1];
+    uint8_t res = 0b00;
+    if (region == NULL
+	|| !region->writable
+	|| region->type == MEMORY_PROGMEM
+	|| count > BUF_MAX) {
+      while (count--) m_owi.read();
+      m_owi.read();
+    }
+    else if (m_owi.read(buf, count + 1)) {
+      uint8_t* mp = (uint8_t*) region->mem + offset;
+#if defined(ARDUINO_ARCH_AVR)
+      if (region->type == MEMORY_EEPROM)
+	eeprom_write_block(buf, mp, count);
+#endif
+      if (region->type == MEMORY_SRAM)
+	memcpy(mp, buf, count);
+      res = 0b10;
+    }
+    m_owi.write(res, 2);
+    return (!m_owi.timedout());
+  }
+};
+};
+#endif
@@ -0,0 +1,317 @@
+/**
+ * @file Slave/Multi.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef SLAVE_MULTI_H
+#define SLAVE_MULTI_H
+
+#include "Slave/OWI.h"
+
+/**
+ * One Wire Interface (OWI) Slave Device template class with several
+ * identities on one pin. Each identity has a rom code, label, alarm
+ * setting, and function command handler. The identities take part
+ * in rom and alarm search as separate devices; the bus wired-and of
+ * the identities still in the search is written in the triplet, and
+ * identities not matching the master direction drop out. Match rom,
+ * match label and skip rom select the identity for the function
+ * command handler. The rom bits are kept as bit masks per rom bit
+ * position (column) so that the per slot work is a few mask
+ * operations. Function command parameters should be read with
+ * param(); on broadcast they are read from the bus once and handed
+ * to the handler of each identity.
+ * @param[in] PIN board pin for 1-wire bus.
+ */
+namespace Slave {
+template<BOARD::pin_t PIN>
+class Multi : public OWI<PIN> {
+public:
+  using OWI<PIN>::ROM_MAX;
+  using OWI<PIN>::ROMBITS;
+  using OWI<PIN>::READ_ROM;
+  using OWI<PIN>::MATCH_ROM;
+  using OWI<PIN>::SKIP_ROM;
+  using OWI<PIN>::SEARCH_ROM;
+  using OWI<PIN>::ALARM_SEARCH;
+  using OWI<PIN>::LABEL_ROM;
+  using OWI<PIN>::READ_LABEL;
+  using OWI<PIN>::MATCH_LABEL;
+
+  /** Identity set bit mask. */
+  typedef uint16_t mask_t;
+
+  /** Max number of identities. */
+  static const uint8_t IDENTITY_MAX = sizeof(mask_t) * 8;
+
+  /** Selection for broadcast (skip rom). */
+  static const uint8_t BROADCAST = 255;
+
+  /** Max number of broadcast function command parameter bytes. */
+  static const uint8_t PARAM_MAX = 8;
+
+  struct identity_t;
+
+  /**
+   * Function command handler. Called with the slave device, the
+   * selected identity, and the function command. On broadcast
+   * (skip rom) the handler is called for each identity and should
+   * not write to the bus; see broadcast(). Parameters are read with
+   * param().
+   * @param[in] slave device.
+   * @param[in] id selected identity.
+   * @param[in] cmd function command.
+   */
+  typedef void (*handler_t)(Multi& slave, identity_t& id, uint8_t cmd);
+
+  /**
+   * Identity; rom code, label and function command handler. The
+   * rom code check sum is generated by the constructor.
+   */
+  struct identity_t {
+    uint8_t rom[ROM_MAX];		//!< Rom code.
+    uint8_t label;			//!< Label (short address).
+    handler_t handler;			//!< Function command handler.
+  };
+
+  /**
+   * Construct one wire bus slave device with given identity table.
+   * The rom codes are completed with check sum, and must not change.
+   * @param[in] identity table.
+   * @param[in] count number of identities (max IDENTITY_MAX).
+   */
+  Multi(identity_t* identity, uint8_t count) :
+    OWI<PIN>(),
+    m_identity(identity),
+    m_count(count > IDENTITY_MAX ? IDENTITY_MAX : count),
+    m_alarms(0),
+    m_selected(BROADCAST),
+    m_params(0)
+  {
+    memset(m_column, 0, sizeof(m_column));
+    for (uint8_t ix = 0; ix < m_count; ix++) {
+      uint8_t* rom = m_identity[ix].rom;
+      uint8_t crc = 0;
+      for (uint8_t i = 0; i < ROM_MAX - 1; i++)
+	crc = OWI<PIN>::crc_update(crc, rom[i]);
+      rom[ROM_MAX - 1] = crc;
+      for (uint8_t i = 0; i < ROMBITS; i++)
+	if (rom[i / 8] & (1 << (i & 7))) m_column[i] |= ((mask_t) 1 << ix);
+    }
+  }
+
+  /**
+   * Get alarm setting for given identity.
+   * @param[in] ix identity index.
+   * @return alarm setting.
+   */
+  bool alarm(uint8_t ix)
+  {
+    return ((m_alarms & ((mask_t) 1 << ix)) != 0);
+  }
+
+  /**
+   * Set alarm for given identity to given value.
+   * @param[in] ix identity index.
+   * @param[in] value alarm setting.
+   */
+  void alarm(uint8_t ix, bool value)
+  {
+    if (value)
+      m_alarms |= ((mask_t) 1 << ix);
+    else
+      m_alarms &= ~((mask_t) 1 << ix);
+  }
+
+  /**
+   * Get index of given identity.
+   * @param[in] id identity.
+   * @return index.
+   */
+  uint8_t index(const identity_t& id)
+  {
+    return (&id - m_identity);
+  }
+
+  /**
+   * Check if the latest function command was a broadcast (skip rom).
+   * @return true(1) if broadcast otherwise false(0).
+   */
+  bool broadcast()
+  {
+    return (m_selected == BROADCAST);
+  }
+
+  /**
+   * Read given number of function command parameter bytes to given
+   * buffer. On broadcast the parameters are read from the bus by the
+   * first handler and the same bytes are given to the following
+   * handlers; at most PARAM_MAX bytes. Returns true(1) if the
+   * parameters were received otherwise false(0).
+   * @param[in] buf buffer pointer.
+   * @param[in] count number of bytes to read.
+   * @return true(1) if received otherwise false(0).
+   */
+  bool param(void* buf, size_t count)
+  {
+    if (m_selected != BROADCAST) {
+      this->read(buf, count);
+      return (!this->m_timedout);
+    }
+    if (count > PARAM_MAX) return (false);
+    while (m_params < count && !this->m_timedout)
+      m_param[m_params++] = this->read();
+    if (this->m_timedout) return (false);
+    memcpy(buf, m_param, count);
+    return (true);
+  }
+
+  /**
+   * Get selected identity index, or BROADCAST, from the latest rom
+   * command.
+   * @return index or BROADCAST.
+   */
+  uint8_t selected()
+  {
+    return (m_selected);
+  }
+
+  /**
+   * Check for reset and standard rom commands. Selects the identity
+   * addressed by match rom, match label or search, or all identities
+   * for skip rom. Returns true(1) if an identity was selected and a
+   * function command will follow, otherwise false(0).
+   * @return true(1) if selected otherwise false(0).
+   */
+  bool rom_command()
+  {
+    if (!this->reset()) return (false);
+    if (m_count == 0) return (false);
+    mask_t active = (m_count == IDENTITY_MAX) ?
+      (mask_t) ~0 :
+      ((mask_t) 1 << m_count) - 1;
+    switch (this->read()) {
+    case READ_ROM:
+      // Only valid with a single identity
+      if (m_count == 1) this->write(m_identity[0].rom, ROM_MAX - 1);
+      return (false);
+    case SKIP_ROM:
+      m_selected = BROADCAST;
+      return (true);
+    case MATCH_ROM:
+      // Narrow the identity set per rom bit from master
+      for (uint8_t i = 0; i < ROMBITS; i++) {
+	mask_t ones = m_column[i];
+	active &= this->read(1) ? ones : ~ones;
+      }
+      break;
+    case MATCH_LABEL:
+      {
+	uint8_t label = this->read();
+	for (uint8_t ix = 0; ix < m_count; ix++) {
+	  if (m_identity[ix].label == label) {
+	    m_selected = ix;
+	    return (!this->m_timedout);
+	  }
+	}
+      }
+      return (false);
+    case ALARM_SEARCH:
+      active &= m_alarms;
+      if (active == 0) return (false);
+    case SEARCH_ROM:
+      // Write wired-and of rom bit and complement for the active
+      // identities, and drop identities not in master direction
+      for (uint8_t i = 0; i < ROMBITS; i++) {
+	mask_t ones = active & m_column[i];
+	mask_t zeros = active & ~m_column[i];
+	this->write(zeros == 0, 1);
+	this->write(ones == 0, 1);
+	active = this->read(1) ? ones : zeros;
+	if (active == 0) return (false);
+      }
+      break;
+    default:
+      return (false);
+    }
+    if (active == 0 || this->m_timedout) return (false);
+    uint8_t ix = 0;
+    while ((active & 1) == 0) {
+      active >>= 1;
+      ix += 1;
+    }
+    m_selected = ix;
+    return (true);
+  }
+
+  /**
+   * Check for reset and rom command, and dispatch function command to
+   * the selected identity handler. Label commands are handled for the
+   * selected identity. Returns true(1) if a function command was
+   * dispatched, otherwise false(0).
+   * @return true(1) if dispatched otherwise false(0).
+   */
+  bool dispatch()
+  {
+    if (!rom_command()) return (false);
+    uint8_t cmd = this->read();
+    if (this->m_timedout) return (false);
+    if (m_selected == BROADCAST) {
+      if (cmd == LABEL_ROM || cmd == READ_LABEL) return (false);
+      m_params = 0;
+      for (uint8_t ix = 0; ix < m_count; ix++) {
+	identity_t& id = m_identity[ix];
+	if (id.handler != NULL) id.handler(*this, id, cmd);
+      }
+      return (true);
+    }
+    identity_t& id = m_identity[m_selected];
+    switch (cmd) {
+    case LABEL_ROM:
+      id.label = this->read();
+      return (false);
+    case READ_LABEL:
+      this->write(id.label);
+      return (false);
+    default:
+      if (id.handler == NULL) return (false);
+      id.handler(*this, id, cmd);
+      return (true);
+    }
+  }
+
+protected:
+  /** Identity table. */
+  identity_t* m_identity;
+
+  /** Number of identities. */
+  uint8_t m_count;
+
+  /** Identities with alarm set. */
+  mask_t m_alarms;
+
+  /** Selected identity index or BROADCAST. */
+  uint8_t m_selected;
+
+  /** Broadcast function command parameters read from bus. */
+  uint8_t m_param[PARAM_MAX];
+  uint8_t m_params;
+
+  /** Identities with rom bit set; per rom bit position. */
+  mask_t m_column[ROMBITS];
+};
+};
+#endif
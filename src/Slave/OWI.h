@@ -38,6 +38,35 @@ public:
   /** One Wire device identity ROM size in bits. */
   static const size_t ROMBITS = ROM_MAX * 8;
 
+  /**
+   * Slot timing (us). The master bit is sampled SAMPLE_POINT after
+   * the falling edge; between the master write one low time (6 us)
+   * and write zero low time (60 us). A zero bit is written by holding
+   * the bus low for WRITE0_HOLD, past the master sample point (15 us).
+   */
+  static const uint16_t RESET_MIN = 410;
+  static const uint16_t PRESENCE_PULSE = 100;
+  static const uint16_t SAMPLE_POINT = 20;
+  static const uint16_t WRITE0_HOLD = 20;
+
+  /**
+   * Default slot wait timeout (ms). The wait for the master to start
+   * a bit slot is bounded by the timeout, and polls the bus with
+   * interrupts disabled in chunks of SLOT_WAIT_CHUNK samples.
+   * Interrupts are enabled between chunks so that millis() and
+   * other interrupt handlers run during long waits. An interrupt
+   * handler that runs between chunks delays detection of the slot
+   * start by its execution time. The slave must pull the bus low for
+   * a zero bit before the master samples (15 us after the falling
+   * edge), so the longest interrupt handler in the sketch must be
+   * shorter than approx. 10 us. Longer handlers, e.g. software serial
+   * or long timer handlers, cause read bit errors in the master, and
+   * their interrupt sources should be disabled while the slave is on
+   * the bus.
+   */
+  static const uint16_t SLOT_TIMEOUT = 16;
+  static const uint8_t SLOT_WAIT_CHUNK = 16;
+
   /**
    * Construct one wire bus slave device connected to the given
    * template pin parameter, and rom identity code. Cyclic redundancy
@@ -47,7 +76,9 @@ public:
   OWI(const uint8_t* rom) :
     m_timestamp(0),
     m_label(255),
-    m_alarm(false)
+    m_alarm(false),
+    m_timeout(SLOT_TIMEOUT),
+    m_timedout(false)
   {
     uint8_t crc = 0;
     for (size_t i = 0; i < ROM_MAX - 1; i++) {
@@ -62,19 +93,28 @@ public:
   /**
    * Construct one wire bus slave device connected to the given
    * template pin parameter, and family code. Random identity code
-   * is generated.
+   * is generated; from the power-on contents of the first memory
+   * bytes on the board, otherwise random().
    * @param[in] family code
    */
   OWI(uint8_t family) :
     m_timestamp(0),
     m_label(255),
-    m_alarm(false)
+    m_alarm(false),
+    m_timeout(SLOT_TIMEOUT),
+    m_timedout(false)
   {
     uint8_t crc = crc_update(0, family);
+#if defined(ARDUINO)
     uint8_t* p = 0;
+#endif
     m_rom[0] = family;
     for (size_t i = 1; i < ROM_MAX - 1; i++) {
+#if defined(ARDUINO)
       uint8_t data = *p++;
+#else
+      uint8_t data = random(256);
+#endif
       m_rom[i] = data;
       crc = crc_update(crc, data);
     }
@@ -119,6 +159,34 @@ public:
     m_alarm = value;
   }
 
+  /**
+   * Get slot wait timeout.
+   * @return milli-seconds.
+   */
+  uint16_t timeout()
+  {
+    return (m_timeout);
+  }
+
+  /**
+   * Set slot wait timeout.
+   * @param[in] ms milli-seconds.
+   */
+  void timeout(uint16_t ms)
+  {
+    m_timeout = ms;
+  }
+
+  /**
+   * Check if a read or write has timed out since the latest reset.
+   * Further read and write are ignored until the next reset.
+   * @return true(1) on timeout, otherwise false(0).
+   */
+  bool timedout()
+  {
+    return (m_timedout);
+  }
+
   /**
    * Check for reset signal. Return true(1) if reset was detected and
    * presence was signaled, otherwise false(0).
@@ -136,19 +204,21 @@ public:
     if (!m_pin) return (false);
 
     // Check reset pulse width
-    if (micros() - m_timestamp < 410) {
+    if (micros() - m_timestamp < RESET_MIN) {
       m_timestamp = 0;
       return (false);
     }
 
     // Generate presence signal
     m_pin.output();
-    delayMicroseconds(100);
+    delayMicroseconds(PRESENCE_PULSE);
     m_pin.input();
 
     // Wait for possible presence signals from other devices
-    while (!m_pin);
     m_timestamp = 0;
+    if (!wait(true)) return (false);
+    interrupts();
+    m_timedout = false;
 
     return (true);
   }
@@ -164,12 +234,12 @@ public:
     uint8_t adjust = 8 - bits;
     uint8_t res = 0;
     uint8_t mix = 0;
+    if (m_timedout) return (0);
     do {
-      noInterrupts();
-      // Wait for bit start
-      while (m_pin);
+      // Wait for bit start; returns with interrupts disabled
+      if (!wait(false)) return (0);
       // Delay to sample bit value
-      delayMicroseconds(20);
+      delayMicroseconds(SAMPLE_POINT);
       res >>= 1;
       if (m_pin) {
 	res |= 0x80;
@@ -185,7 +255,10 @@ public:
       // Wait for bit end (max 50 us)
       uint8_t count = 255;
       while (!m_pin && --count);
-      if (count == 0) return (0);
+      if (count == 0) {
+	m_timedout = true;
+	return (0);
+      }
     } while (--bits);
     res >>= adjust;
     return (res);
@@ -223,14 +296,14 @@ public:
   void write(uint8_t value, uint8_t bits = 8)
   {
     uint8_t mix = 0;
+    if (m_timedout) return;
     do {
-      noInterrupts();
-      // Wait for bit start
-      while (m_pin);
+      // Wait for bit start; returns with interrupts disabled
+      if (!wait(false)) return;
       // Streck low if bit is zero
       if ((value & 0x01) == 0) {
 	m_pin.output();
-	delayMicroseconds(20);
+	delayMicroseconds(WRITE0_HOLD);
 	m_pin.input();
 	mix = (m_crc ^ 0);
       }
@@ -245,7 +318,10 @@ public:
       // Wait for bit end (max 50 us)
       uint8_t count = 255;
       while (!m_pin && --count);
-      if (count == 0) return;
+      if (count == 0) {
+	m_timedout = true;
+	return;
+      }
     } while (--bits);
   }
 
@@ -269,6 +345,42 @@ public:
     write(m_crc);
   }
 
+  /**
+   * Write given number of bytes to one wire bus master without check
+   * sum calculation. Used for responses with precomputed check sum,
+   * see Slave::Device::Response.
+   * @param[in] buf buffer to write.
+   * @param[in] count number of bytes to write.
+   */
+  void send(const void* buf, size_t count)
+  {
+    const uint8_t* bp = (const uint8_t*) buf;
+    if (m_timedout) return;
+    while (count--) {
+      uint8_t value = *bp++;
+      uint8_t bits = 8;
+      do {
+	// Wait for bit start; returns with interrupts disabled
+	if (!wait(false)) return;
+	// Streck low if bit is zero
+	if ((value & 0x01) == 0) {
+	  m_pin.output();
+	  delayMicroseconds(WRITE0_HOLD);
+	  m_pin.input();
+	}
+	interrupts();
+	value >>= 1;
+	// Wait for bit end (max 50 us)
+	uint8_t n = 255;
+	while (!m_pin && --n);
+	if (n == 0) {
+	  m_timedout = true;
+	  return;
+	}
+      } while (--bits);
+    }
+  }
+
   /**
    * Write bit and inverse bit. Return read bit.
    * @param[in] bit to write.
@@ -389,6 +501,23 @@ public:
   }
 
 protected:
+  /**
+   * Construct one wire bus slave device connected to the given
+   * template pin parameter, without rom identity code. Used by
+   * slave classes with other identity handling, e.g. Slave::Multi.
+   */
+  OWI() :
+    m_timestamp(0),
+    m_label(255),
+    m_alarm(false),
+    m_crc(0),
+    m_timeout(SLOT_TIMEOUT),
+    m_timedout(false)
+  {
+    memset(m_rom, 0, sizeof(m_rom));
+    m_pin.open_drain();
+  }
+
   /** 1-Wire bus pin. */
   GPIO<PIN> m_pin;
 
@@ -406,6 +535,37 @@ protected:
 
   /** Intermediate cyclic redundancy check sum. */
   uint8_t m_crc;
+
+  /** Slot wait timeout (ms). */
+  uint16_t m_timeout;
+
+  /** Slot wait timeout since latest reset. */
+  bool m_timedout;
+
+  /**
+   * Wait for the bus to reach the given level. The bus is polled
+   * with interrupts disabled in chunks, and interrupts are enabled
+   * between chunks; the edge detection latency is limited by the
+   * interrupt handlers, see SLOT_WAIT_CHUNK. Returns true(1) with
+   * interrupts disabled when the level was detected, otherwise
+   * false(0) on timeout with interrupts enabled.
+   * @param[in] level to wait for.
+   * @return true(1) if level detected, otherwise false(0).
+   */
+  bool wait(bool level)
+  {
+    uint16_t start = millis();
+    do {
+      uint8_t count = SLOT_WAIT_CHUNK;
+      noInterrupts();
+      do {
+	if (m_pin == level) return (true);
+      } while (--count);
+      interrupts();
+    } while ((uint16_t) (((uint16_t) millis()) - start) < m_timeout);
+    m_timedout = true;
+    return (false);
+  }
 };
 };
 #endif
@@ -34,32 +34,104 @@ public:
    * Construct one wire bus connected to the given template pin
    * parameter.
    */
-  OWI()
+  OWI() :
+    m_irq_policy(IRQ_SLOT),
+    m_irq_probe(false),
+    m_irq_max(0)
   {
     m_pin.open_drain();
   }
 
+  /**
+   * Interrupts-off policy. IRQ_SLOT disables interrupts for the
+   * whole bit slot (max 70 us). IRQ_PHASE disables interrupts only
+   * for the timing critical phase of the slot; read sample and write
+   * one low pulse (max 15 us). A write zero low pulse may then be
+   * stretched by interrupt handlers and these must be shorter than
+   * 60 us.
+   */
+  enum {
+    IRQ_SLOT = 0,		//!< Interrupts off during bit slot.
+    IRQ_PHASE = 1		//!< Interrupts off during critical phase.
+  } __attribute__((packed));
+
+  /**
+   * Set interrupts-off policy.
+   * @param[in] policy IRQ_SLOT or IRQ_PHASE.
+   */
+  void irq_policy(uint8_t policy)
+  {
+    m_irq_policy = policy;
+  }
+
+  /**
+   * Enable or disable measurement of interrupts-off windows. The
+   * longest window of the bit slots is recorded when enabled.
+   * @param[in] enable measurement.
+   */
+  void irq_probe(bool enable)
+  {
+    m_irq_probe = enable;
+  }
+
+  /**
+   * Get longest measured interrupts-off window in micro-seconds.
+   * @return micro-seconds.
+   */
+  uint16_t irq_max() const
+  {
+    return (m_irq_max);
+  }
+
+  /**
+   * Clear longest measured interrupts-off window.
+   */
+  void irq_max_clear()
+  {
+    m_irq_max = 0;
+  }
+
   /**
    * @override{OWI}
    * Reset the one wire bus and check that at least one device is
-   * presence.
+   * presence. Fails fast, without accessing the bus, during the
+   * backoff period after an empty or shorted bus. The bus is checked
+   * for short before the reset pulse, and retried only if devices
+   * were present on the previous reset. See bus_state().
    * @return true(1) if successful otherwise false(0).
    */
   virtual bool reset()
   {
-    uint8_t retry = RESET_RETRY_MAX;
+    // Check backoff period and that the bus is not held low
+    if (backoff()) return (false);
+    if (!m_pin) {
+      delayMicroseconds(WRITE0_LOW + WRITE0_RECOVERY);
+      if (!m_pin) {
+	bus_state(BUS_SHORTED);
+	return (false);
+      }
+    }
+
+    // Generate reset pulse and sample presence; check bus release
+    uint8_t retry = (m_bus_state == BUS_PRESENT) ? RESET_RETRY_MAX : 0;
     bool res;
+    bool released;
     do {
       m_pin.output();
-      delayMicroseconds(490);
-      noInterrupts();
+      delayMicroseconds(RESET_PULSE);
+      uint16_t start = irq_begin();
       m_pin.input();
-      delayMicroseconds(70);
+      delayMicroseconds(PRESENCE_SAMPLE);
       res = m_pin;
-      interrupts();
-      delayMicroseconds(410);
+      irq_end(start);
+      delayMicroseconds(RESET_RECOVERY);
+      released = m_pin;
     } while (retry-- && res);
-    return (res == 0);
+    if (res)
+      bus_state(BUS_EMPTY);
+    else
+      bus_state(released ? BUS_PRESENT : BUS_GLITCH);
+    return (m_bus_state == BUS_PRESENT);
   }
 
   /**
@@ -74,15 +146,15 @@ public:
     uint8_t adjust = CHARBITS - bits;
     uint8_t res = 0;
     while (bits--) {
-      noInterrupts();
+      uint16_t start = irq_begin();
       m_pin.output();
-      delayMicroseconds(6);
+      delayMicroseconds(READ_LOW);
       m_pin.input();
-      delayMicroseconds(9);
+      delayMicroseconds(READ_SAMPLE);
       res >>= 1;
       res |= (m_pin ? 0x80 : 0x00);
-      interrupts();
-      delayMicroseconds(55);
+      irq_end(start);
+      delayMicroseconds(READ_RECOVERY);
     }
     res >>= adjust;
     return (res);
@@ -98,19 +170,21 @@ public:
   virtual void write(uint8_t value, uint8_t bits = CHARBITS)
   {
     while (bits--) {
-      noInterrupts();
+      uint16_t start = irq_begin();
       m_pin.output();
       if (value & 0x01) {
-	delayMicroseconds(6);
+	delayMicroseconds(WRITE1_LOW);
 	m_pin.input();
-	delayMicroseconds(64);
+	if (m_irq_policy == IRQ_PHASE) irq_end(start);
+	delayMicroseconds(WRITE1_RECOVERY);
       }
       else {
-	delayMicroseconds(60);
+	if (m_irq_policy == IRQ_PHASE) irq_end(start);
+	delayMicroseconds(WRITE0_LOW);
 	m_pin.input();
-	delayMicroseconds(10);
+	delayMicroseconds(WRITE0_RECOVERY);
       }
-      interrupts();
+      if (m_irq_policy == IRQ_SLOT) irq_end(start);
       value >>= 1;
     }
   }
@@ -118,9 +192,73 @@ public:
   using ::OWI::read;
   using ::OWI::write;
 
+  /**
+   * Standard speed slot timing (us). A read slot is sampled
+   * READ_LOW + READ_SAMPLE (15 us) after the falling edge, and a
+   * write zero slot holds the bus low for WRITE0_LOW (60 us). Slave
+   * devices, e.g. Slave::OWI, must sample and drive within these
+   * windows.
+   */
+  static const uint16_t RESET_PULSE = 490;
+  static const uint16_t PRESENCE_SAMPLE = 70;
+  static const uint16_t RESET_RECOVERY = 410;
+  static const uint16_t READ_LOW = 6;
+  static const uint16_t READ_SAMPLE = 9;
+  static const uint16_t READ_RECOVERY = 55;
+  static const uint16_t WRITE1_LOW = 6;
+  static const uint16_t WRITE1_RECOVERY = 64;
+  static const uint16_t WRITE0_LOW = 60;
+  static const uint16_t WRITE0_RECOVERY = 10;
+
+  /**
+   * Line time profile (us) for OWI::Cost; reset, bit, byte read and
+   * write, and search triplet (two read and one write slot).
+   */
+  static const uint16_t RESET_TIME =
+    RESET_PULSE + PRESENCE_SAMPLE + RESET_RECOVERY;
+  static const uint16_t BIT_TIME = READ_LOW + READ_SAMPLE + READ_RECOVERY;
+  static const uint16_t READ_TIME = CHARBITS * BIT_TIME;
+  static const uint16_t WRITE_TIME =
+    CHARBITS * (WRITE0_LOW + WRITE0_RECOVERY);
+  static const uint16_t TRIPLET_TIME = 3 * BIT_TIME;
+
 protected:
   /** 1-Wire bus pin. */
   GPIO<PIN> m_pin;
+
+  /** Interrupts-off policy. */
+  uint8_t m_irq_policy;
+
+  /** Interrupts-off window measurement enabled. */
+  bool m_irq_probe;
+
+  /** Longest interrupts-off window in micro-seconds. */
+  uint16_t m_irq_max;
+
+  /**
+   * Disable interrupts and return start timestamp for irq_end() if
+   * measurement is enabled.
+   * @return timestamp.
+   */
+  uint16_t irq_begin()
+  {
+    uint16_t start = m_irq_probe ? micros() : 0;
+    noInterrupts();
+    return (start);
+  }
+
+  /**
+   * Enable interrupts and record the interrupts-off window from the
+   * given start timestamp if measurement is enabled.
+   * @param[in] start timestamp from irq_begin().
+   */
+  void irq_end(uint16_t start)
+  {
+    interrupts();
+    if (!m_irq_probe) return;
+    uint16_t us = ((uint16_t) micros()) - start;
+    if (us > m_irq_max) m_irq_max = us;
+  }
 };
 };
 #endif
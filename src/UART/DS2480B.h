@@ -0,0 +1,296 @@
+/**
+ * @file UART/DS2480B.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef UART_DS2480B_H
+#define UART_DS2480B_H
+
+#include "OWI.h"
+
+/**
+ * One Wire Interface (OWI) Bus Manager class using DS2480B, Serial
+ * 1-Wire Line Driver (DS9097U adapter). Byte transfers are
+ * performed in data mode and bit transfers in command mode. Block
+ * transfers are pipelined in data mode, and search uses the search
+ * accelerator; one 16 byte exchange per search pass.
+ * @section References
+ * 1. DS2480B Serial to 1-Wire Line Driver, Datasheet.
+ * 2. Application Note 192, Using the DS2480B Serial 1-Wire Line Driver.
+ */
+namespace UART {
+class DS2480B : public ::OWI {
+public:
+  /**
+   * Construct one wire bus manager for DS2480B connected to given
+   * serial port.
+   * @param[in] serial port.
+   */
+  DS2480B(HardwareSerial& serial) :
+    m_serial(serial),
+    m_mode(COMMAND_MODE)
+  {
+  }
+
+  /**
+   * Initiate line driver; generate break, and send timing byte
+   * (reset command) at 9600 baud. Should be called before any other
+   * operation.
+   */
+  void begin()
+  {
+    m_serial.begin(BREAK_BAUDRATE);
+    m_serial.write((uint8_t) 0);
+    m_serial.flush();
+    m_serial.begin(BAUDRATE);
+    delay(2);
+    m_serial.write(RESET);
+    m_serial.flush();
+    delay(2);
+    while (m_serial.available()) m_serial.read();
+    m_mode = COMMAND_MODE;
+  }
+
+  /**
+   * @override{OWI}
+   * Reset the one wire bus and check that at least one device is
+   * presence. The reset command response gives bus state.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool reset()
+  {
+    if (backoff()) return (false);
+    command_mode();
+    m_serial.write(RESET);
+    int res = recv();
+    if (res < 0) {
+      bus_state(BUS_EMPTY);
+      return (false);
+    }
+    switch (res & RESET_MASK) {
+    case RESET_SHORTED:
+      bus_state(BUS_SHORTED);
+      break;
+    case RESET_NO_PRESENCE:
+      bus_state(BUS_EMPTY);
+      break;
+    default:
+      bus_state(BUS_PRESENT);
+    }
+    return (m_bus_state == BUS_PRESENT);
+  }
+
+  /**
+   * @override{OWI}
+   * Read the given number of bits from the one wire bus. Default
+   * number of bits is 8.
+   * @param[in] bits to be read.
+   * @return value read.
+   */
+  virtual uint8_t read(uint8_t bits = CHARBITS)
+  {
+    if (bits == CHARBITS) {
+      uint8_t res = 0xff;
+      exchange(&res, &res, 1);
+      return (res);
+    }
+    uint8_t adjust = CHARBITS - bits;
+    uint8_t res = 0;
+    command_mode();
+    while (bits--) {
+      m_serial.write(SINGLE_BIT | BIT_ONE);
+      res >>= 1;
+      if (recv() & 0x01) res |= 0x80;
+    }
+    res >>= adjust;
+    return (res);
+  }
+
+  /**
+   * @override{OWI}
+   * Write the given value to the one wire bus. The bits are written
+   * from LSB to MSB.
+   * @param[in] value to write.
+   * @param[in] bits to be written.
+   */
+  virtual void write(uint8_t value, uint8_t bits = CHARBITS)
+  {
+    if (bits == CHARBITS) {
+      exchange(&value, NULL, 1);
+      return;
+    }
+    command_mode();
+    while (bits--) {
+      m_serial.write(SINGLE_BIT | ((value & 0x01) ? BIT_ONE : 0));
+      recv();
+      value >>= 1;
+    }
+  }
+
+  using ::OWI::read;
+  using ::OWI::write;
+
+  /**
+   * DS2480B command mode commands, mode switch and response codes
+   * (regular speed).
+   */
+  enum {
+    DATA_MODE = 0xe1,		//!< Switch to data mode.
+    COMMAND_MODE = 0xe3,	//!< Switch to command mode.
+    RESET = 0xc1,		//!< Reset 1-Wire bus.
+    SINGLE_BIT = 0x81,		//!< Single bit (write zero/read).
+    BIT_ONE = 0x10,		//!< Single bit value one.
+    SEARCH_ON = 0xb1,		//!< Search accelerator on.
+    SEARCH_OFF = 0xa1,		//!< Search accelerator off.
+    RESET_MASK = 0x03,		//!< Reset response mask.
+    RESET_SHORTED = 0x00,	//!< Bus shorted.
+    RESET_PRESENCE = 0x01,	//!< Presence pulse.
+    RESET_ALARM = 0x02,		//!< Alarming presence pulse.
+    RESET_NO_PRESENCE = 0x03	//!< No presence pulse.
+  } __attribute__((packed));
+
+  /**
+   * Serial port configuration; baudrate, break generation baudrate,
+   * number of data bytes in flight and response timeout (ms).
+   */
+  static const uint32_t BAUDRATE = 9600;
+  static const uint32_t BREAK_BAUDRATE = 4800;
+  static const uint8_t DATA_WINDOW = 8;
+  static const uint16_t RESPONSE_TIMEOUT = 20;
+
+protected:
+  /** Serial port. */
+  HardwareSerial& m_serial;
+
+  /** Current mode; DATA_MODE or COMMAND_MODE. */
+  uint8_t m_mode;
+
+  using ::OWI::search;
+
+  /**
+   * @override{OWI}
+   * Search device rom given the last position of discrepancy and
+   * partial or full rom code. The search pass is performed with the
+   * search accelerator. The direction for each bit position is sent
+   * as r-bits (odd bits) and the response holds the discrepancy
+   * flag (even bits) and chosen direction (odd bits); two bits per
+   * rom bit, LSB first.
+   * @param[in] code device identity rom.
+   * @param[in] last position of discrepancy (default FIRST).
+   * @return position of difference or negative error code.
+   */
+  virtual int8_t search(uint8_t* code, int8_t last = FIRST)
+  {
+    uint8_t buf[ROM_MAX * 2];
+    memset(buf, 0, sizeof(buf));
+    for (uint8_t pos = 0; pos < ROMBITS; pos++) {
+      uint8_t i = pos / CHARBITS;
+      uint8_t j = pos & 0x07;
+      bool dir = (pos == last) || ((pos < last) && (code[i] & (1 << j)));
+      if (dir) buf[pos / 4] |= (0x02 << ((pos & 0x03) * 2));
+    }
+    command_mode();
+    m_serial.write(SEARCH_ON);
+    bool res = exchange(buf, buf, sizeof(buf));
+    command_mode();
+    m_serial.write(SEARCH_OFF);
+    if (!res) return (ERROR);
+    int8_t next = LAST;
+    for (uint8_t pos = 0; pos < ROMBITS; pos++) {
+      uint8_t i = pos / CHARBITS;
+      uint8_t j = pos & 0x07;
+      uint8_t bits = buf[pos / 4] >> ((pos & 0x03) * 2);
+      if (bits & 0x02)
+	code[i] |= (1 << j);
+      else {
+	code[i] &= ~(1 << j);
+	if (bits & 0x01) next = pos;
+      }
+    }
+    return (next);
+  }
+
+  /**
+   * Switch to command mode if in data mode.
+   */
+  void command_mode()
+  {
+    if (m_mode == COMMAND_MODE) return;
+    m_serial.write(COMMAND_MODE);
+    m_mode = COMMAND_MODE;
+  }
+
+  /**
+   * Switch to data mode if in command mode.
+   */
+  void data_mode()
+  {
+    if (m_mode == DATA_MODE) return;
+    m_serial.write(DATA_MODE);
+    m_mode = DATA_MODE;
+  }
+
+  /**
+   * Receive response. Returns byte or negative error code on
+   * timeout.
+   * @return byte or negative error code.
+   */
+  int recv()
+  {
+    uint16_t start = millis();
+    while (!m_serial.available()) {
+      if ((uint16_t) (((uint16_t) millis()) - start) > RESPONSE_TIMEOUT)
+	return (-1);
+    }
+    return (m_serial.read());
+  }
+
+  /**
+   * @override{OWI}
+   * Exchange given number of bytes in data mode. Writes bytes from
+   * source buffer, or reads when null, and stores bytes read in
+   * destination buffer, if not null. The source and destination
+   * may be the same buffer. The mode switch byte is escaped by
+   * sending it twice. At most DATA_WINDOW bytes are in flight; used
+   * by transfer() to pipeline read and write segments, and by the
+   * search pass. Returns false(0) if the response was lost.
+   * @param[in] src source buffer (or null).
+   * @param[in] dst destination buffer (or null).
+   * @param[in] count number of bytes.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool exchange(const uint8_t* src, uint8_t* dst, size_t count)
+  {
+    size_t tx = 0;
+    size_t rx = 0;
+    data_mode();
+    while (rx < count) {
+      while (tx < count && tx - rx < DATA_WINDOW) {
+	uint8_t value = (src != NULL) ? src[tx] : 0xff;
+	m_serial.write(value);
+	if (value == COMMAND_MODE) m_serial.write(value);
+	tx += 1;
+      }
+      int res = recv();
+      if (res < 0) return (false);
+      if (dst != NULL) dst[rx] = res;
+      rx += 1;
+    }
+    return (true);
+  }
+};
+};
+#endif
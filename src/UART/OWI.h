@@ -0,0 +1,194 @@
+/**
+ * @file UART/OWI.h
+ * @version 1.0
+ *
+ * @section License
+ * Copyright (C) 2017, Mikael Patel
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ */
+
+#ifndef UART_OWI_H
+#define UART_OWI_H
+
+#include "OWI.h"
+
+/**
+ * One Wire Interface (OWI) Bus Manager class using a hardware
+ * serial port. The 1-wire bus is connected to RX and TX with an open
+ * drain buffer (or diode and pullup). The reset pulse is generated
+ * at 9600 baud, and bit slots at 115200 baud; one serial byte per
+ * slot. The bit value is read from the echo. The serial port
+ * interrupt handlers and buffers perform the bit transfer; block
+ * transfers are pipelined with several slots in flight.
+ * The bus must be reset before any other operation as the reset
+ * configures the serial port.
+ */
+namespace UART {
+class OWI : public ::OWI {
+public:
+  /**
+   * Construct one wire bus manager for given serial port.
+   * @param[in] serial port.
+   */
+  OWI(HardwareSerial& serial) :
+    m_serial(serial)
+  {
+  }
+
+  /**
+   * @override{OWI}
+   * Reset the one wire bus and check that at least one device is
+   * presence. The reset pulse is a 0xF0 byte at 9600 baud. The echo
+   * is modified by presence pulses, and zero if the bus is shorted.
+   * Echoes of slots still in flight, e.g. after a lost echo, are
+   * discarded before the reset pulse. A lost reset echo is an
+   * adapter failure (BUS_ERROR).
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool reset()
+  {
+    if (backoff()) return (false);
+    m_serial.flush();
+    while (m_serial.available()) m_serial.read();
+    m_serial.begin(RESET_BAUDRATE);
+    m_serial.write(RESET_PULSE);
+    int res = recv();
+    m_serial.begin(SLOT_BAUDRATE);
+    if (res < 0)
+      bus_state(BUS_ERROR);
+    else if (res == RESET_PULSE)
+      bus_state(BUS_EMPTY);
+    else if (res == 0)
+      bus_state(BUS_SHORTED);
+    else
+      bus_state(BUS_PRESENT);
+    return (m_bus_state == BUS_PRESENT);
+  }
+
+  /**
+   * @override{OWI}
+   * Read the given number of bits from the one wire bus. Default
+   * number of bits is 8.
+   * @param[in] bits to be read.
+   * @return value read.
+   */
+  virtual uint8_t read(uint8_t bits = CHARBITS)
+  {
+    return (slots(0xff, bits));
+  }
+
+  /**
+   * @override{OWI}
+   * Write the given value to the one wire bus. The bits are written
+   * from LSB to MSB.
+   * @param[in] value to write.
+   * @param[in] bits to be written.
+   */
+  virtual void write(uint8_t value, uint8_t bits = CHARBITS)
+  {
+    slots(value, bits);
+  }
+
+  using ::OWI::read;
+  using ::OWI::write;
+
+  /**
+   * Serial port configuration; reset and slot baudrate, reset pulse
+   * and slot bytes, number of slots in flight and echo timeout (ms).
+   */
+  static const uint32_t RESET_BAUDRATE = 9600;
+  static const uint32_t SLOT_BAUDRATE = 115200;
+  static const uint8_t RESET_PULSE = 0xf0;
+  static const uint8_t SLOT_ONE = 0xff;
+  static const uint8_t SLOT_ZERO = 0x00;
+  static const uint8_t SLOT_WINDOW = 16;
+  static const uint16_t ECHO_TIMEOUT = 4;
+
+protected:
+  /** Serial port. */
+  HardwareSerial& m_serial;
+
+  /**
+   * Receive echo. Returns byte or negative error code on timeout.
+   * @return byte or negative error code.
+   */
+  int recv()
+  {
+    uint16_t start = millis();
+    while (!m_serial.available()) {
+      if ((uint16_t) (((uint16_t) millis()) - start) > ECHO_TIMEOUT)
+	return (-1);
+    }
+    return (m_serial.read());
+  }
+
+  /**
+   * Write given number of bits as slots and return bits read from
+   * echo. All slots are queued before the echo is received.
+   * @param[in] value to write (0xff to read).
+   * @param[in] bits number of slots.
+   * @return value read.
+   */
+  uint8_t slots(uint8_t value, uint8_t bits)
+  {
+    uint8_t adjust = CHARBITS - bits;
+    uint8_t res = 0;
+    for (uint8_t i = 0; i < bits; i++) {
+      m_serial.write((value & 0x01) ? SLOT_ONE : SLOT_ZERO);
+      value >>= 1;
+    }
+    while (bits--) {
+      res >>= 1;
+      if (recv() == SLOT_ONE) res |= 0x80;
+    }
+    res >>= adjust;
+    return (res);
+  }
+
+  /**
+   * @override{OWI}
+   * Exchange given number of bytes. Writes bytes from source buffer,
+   * or reads when null, and stores bytes read in destination buffer,
+   * if not null. At most SLOT_WINDOW slots are in flight; used by
+   * transfer() to pipeline read and write segments. Returns false(0)
+   * if the echo was lost.
+   * @param[in] src source buffer (or null).
+   * @param[in] dst destination buffer (or null).
+   * @param[in] count number of bytes.
+   * @return true(1) if successful otherwise false(0).
+   */
+  virtual bool exchange(const uint8_t* src, uint8_t* dst, size_t count)
+  {
+    size_t bits = count * CHARBITS;
+    size_t tx = 0;
+    size_t rx = 0;
+    uint8_t value = 0;
+    uint8_t res = 0;
+    while (rx < bits) {
+      while (tx < bits && tx - rx < SLOT_WINDOW) {
+	if ((tx & 0x07) == 0) value = (src != NULL) ? *src++ : 0xff;
+	m_serial.write((value & 0x01) ? SLOT_ONE : SLOT_ZERO);
+	value >>= 1;
+	tx += 1;
+      }
+      int echo = recv();
+      if (echo < 0) return (false);
+      res >>= 1;
+      if (echo == SLOT_ONE) res |= 0x80;
+      rx += 1;
+      if ((rx & 0x07) == 0 && dst != NULL) *dst++ = res;
+    }
+    return (true);
+  }
+};
+};
+#endif